@@ -0,0 +1,254 @@
+//
+// gradient_bench.cpp
+// sdl2-sparkling
+//
+// Benchmarks the gradient generator functions on a software renderer
+// and compares the results against a stored baseline.
+//
+// Usage: gradient_bench [--update] [--threshold=percent] [baseline file]
+//
+// Without --update, every case whose throughput dropped by more than
+// 'threshold' percent (10 by default) relative to the baseline is
+// reported as a regression, and the exit status is 1 if there were
+// any. With --update, the baseline file is (re)written instead.
+//
+// Licensed under the 2-clause BSD License
+//
+
+#define SDL_MAIN_HANDLED
+
+#include "sdl2_gradient.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// minimal wall-clock time spent on each case, in seconds
+static const double min_duration = 0.25;
+
+struct BenchCase {
+	std::string name;
+	SPN_SDL_GradientKind kind;
+	int w, h;
+	double vx, vy;
+	unsigned n_stops;
+};
+
+static std::vector<SPN_SDL_ColorStop> make_color_stops(unsigned n)
+{
+	std::vector<SPN_SDL_ColorStop> stops(n);
+
+	for (unsigned i = 0; i < n; i++) {
+		Uint8 v = Uint8(i * 255 / (n - 1));
+		stops[i].color = SDL_Color { v, Uint8(255 - v), Uint8(i * 97), 255 };
+		stops[i].progress = double(i) / (n - 1);
+	}
+
+	return stops;
+}
+
+static std::vector<BenchCase> make_cases()
+{
+	static const int sizes[] = { 64, 256, 1024, 2048 };
+	static const unsigned stop_counts[] = { 2, 8, 32 };
+
+	static const struct {
+		const char *name;
+		double vx, vy;
+	} directions[] = {
+		{ "horizontal", 1,  0 },
+		{ "vertical",   0,  1 },
+		{ "diagonal",   1,  1 },
+		{ "oblique",    3, -2 }
+	};
+
+	std::vector<BenchCase> cases;
+
+	for (int size : sizes) {
+		for (unsigned n : stop_counts) {
+			std::string suffix = "/" + std::to_string(size) + "/" + std::to_string(n);
+
+			for (const auto &dir : directions) {
+				cases.push_back({
+					std::string("linear-") + dir.name + suffix,
+					SPN_SDL_GRADIENT_LINEAR,
+					size,
+					size,
+					dir.vx,
+					dir.vy,
+					n
+				});
+			}
+
+			cases.push_back({ "radial" + suffix, SPN_SDL_GRADIENT_RADIAL, size, size, 0, 0, n });
+			cases.push_back({ "conical" + suffix, SPN_SDL_GRADIENT_CONICAL, size, size, 0, 0, n });
+		}
+	}
+
+	return cases;
+}
+
+static SDL_Texture *generate(SDL_Renderer *renderer, const BenchCase &bc, const SPN_SDL_ColorStop *stops)
+{
+	Uint32 format = spnlib_SDL_preferred_texture_format(renderer);
+
+	switch (bc.kind) {
+	case SPN_SDL_GRADIENT_LINEAR:
+		return spnlib_sdl2_linear_gradient(renderer, format, bc.w, bc.h, bc.vx, bc.vy, stops, bc.n_stops);
+	case SPN_SDL_GRADIENT_RADIAL:
+		return spnlib_sdl2_radial_gradient(renderer, format, bc.w / 2, bc.h / 2, stops, bc.n_stops);
+	case SPN_SDL_GRADIENT_CONICAL:
+	default:
+		return spnlib_sdl2_conical_gradient(renderer, format, bc.w / 2, bc.h / 2, stops, bc.n_stops);
+	}
+}
+
+// Returns the throughput in megapixels (of the requested gradient size) per second
+static double run_case(SDL_Renderer *renderer, const BenchCase &bc)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	std::vector<SPN_SDL_ColorStop> stops = make_color_stops(bc.n_stops);
+
+	// warm up caches and the allocator
+	SDL_Texture *texture = generate(renderer, bc, stops.data());
+	if (texture == NULL) {
+		return 0;
+	}
+	SDL_DestroyTexture(texture);
+
+	long iterations = 0;
+	double elapsed = 0;
+	Clock::time_point start = Clock::now();
+
+	do {
+		SDL_DestroyTexture(generate(renderer, bc, stops.data()));
+		iterations++;
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	} while (elapsed < min_duration);
+
+	return double(bc.w) * bc.h * iterations / elapsed / 1e6;
+}
+
+static std::map<std::string, double> read_baseline(const char *path)
+{
+	std::map<std::string, double> baseline;
+	std::ifstream file(path);
+	std::string line;
+
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		std::istringstream fields(line);
+		std::string name;
+		double mpixels;
+
+		if (fields >> name >> mpixels) {
+			baseline[name] = mpixels;
+		}
+	}
+
+	return baseline;
+}
+
+static bool write_baseline(const char *path, const std::map<std::string, double> &results)
+{
+	std::ofstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	file << "# gradient benchmark baseline, Mpixels/s; regenerate with --update\n";
+
+	for (const auto &result : results) {
+		file << result.first << " " << result.second << "\n";
+	}
+
+	return bool(file);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *baseline_path = "bench/gradient_baseline.txt";
+	double threshold = 10;
+	bool update = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--update") == 0) {
+			update = true;
+		} else if (std::strncmp(argv[i], "--threshold=", 12) == 0) {
+			threshold = std::atof(argv[i] + 12);
+		} else {
+			baseline_path = argv[i];
+		}
+	}
+
+	// a software renderer makes results independent of the GPU and the driver
+	SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_Renderer *renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+
+	if (renderer == NULL) {
+		std::fprintf(stderr, "cannot create software renderer: %s\n", SDL_GetError());
+		return 2;
+	}
+
+	std::map<std::string, double> baseline = read_baseline(baseline_path);
+	std::map<std::string, double> results;
+	int regressions = 0;
+
+	std::printf("%-28s %12s %12s %8s\n", "case", "Mpixels/s", "baseline", "change");
+
+	for (const BenchCase &bc : make_cases()) {
+		double mpixels = run_case(renderer, bc);
+		results[bc.name] = mpixels;
+
+		auto it = baseline.find(bc.name);
+		if (it == baseline.end() || it->second <= 0) {
+			std::printf("%-28s %12.2f %12s %8s\n", bc.name.c_str(), mpixels, "-", "-");
+			continue;
+		}
+
+		double change = (mpixels / it->second - 1) * 100;
+		bool regressed = !update && change < -threshold;
+		regressions += regressed;
+
+		std::printf(
+			"%-28s %12.2f %12.2f %+7.1f%%%s\n",
+			bc.name.c_str(),
+			mpixels,
+			it->second,
+			change,
+			regressed ? "  REGRESSION" : ""
+		);
+	}
+
+	SDL_DestroyRenderer(renderer);
+	SDL_FreeSurface(surface);
+
+	if (update) {
+		if (!write_baseline(baseline_path, results)) {
+			std::fprintf(stderr, "cannot write baseline file '%s'\n", baseline_path);
+			return 2;
+		}
+
+		std::printf("baseline written to '%s'\n", baseline_path);
+		return 0;
+	}
+
+	if (baseline.empty()) {
+		std::printf("no baseline found at '%s'; run with --update to create one\n", baseline_path);
+	} else if (regressions > 0) {
+		std::printf("%d case(s) regressed by more than %g%%\n", regressions, threshold);
+		return 1;
+	}
+
+	return 0;
+}
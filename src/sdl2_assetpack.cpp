@@ -0,0 +1,316 @@
+//
+// sdl2_assetpack.cpp
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#include "sdl2_assetpack.h"
+#include "sdl2_sparkling.h"
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+struct AssetPack {
+	struct Image {
+		int width, height, pitch;
+		const Uint8 *pixels; // inside the mapping
+	};
+
+	void *data;
+	std::size_t size;
+	Uint32 format;
+	std::unordered_map<std::string, Image> images;
+
+	AssetPack(void *d, std::size_t n) : data(d), size(n), format(0) {}
+
+	AssetPack(const AssetPack &) = delete;
+	AssetPack &operator=(const AssetPack &) = delete;
+
+	~AssetPack()
+	{
+		munmap(data, size);
+	}
+
+	// Reads the index, checking that every record lies within the file
+	bool parse()
+	{
+		const Uint8 *base = static_cast<const Uint8 *>(data);
+
+		SPN_SDL_PackHeader header;
+		if (size < sizeof header) {
+			return false;
+		}
+
+		std::memcpy(&header, base, sizeof header);
+
+		if (std::memcmp(header.magic, SPN_SDL_PACK_MAGIC, sizeof SPN_SDL_PACK_MAGIC) != 0
+		 || SDL_SwapLE32(header.version) != SPN_SDL_PACK_VERSION) {
+			return false;
+		}
+
+		format = SDL_SwapLE32(header.format);
+		Uint32 count = SDL_SwapLE32(header.count);
+
+		// the bounds checks below only hold for packed pixels
+		if (SDL_ISPIXELFORMAT_FOURCC(format) || SDL_BYTESPERPIXEL(format) == 0) {
+			return false;
+		}
+
+		if (count > (size - sizeof header) / sizeof(SPN_SDL_PackEntry)) {
+			return false;
+		}
+
+		std::size_t bytes_per_pixel = SDL_BYTESPERPIXEL(format);
+
+		for (Uint32 i = 0; i < count; i++) {
+			SPN_SDL_PackEntry entry;
+			std::memcpy(&entry, base + sizeof header + i * sizeof entry, sizeof entry);
+
+			std::size_t name_offset = SDL_SwapLE32(entry.name_offset);
+			Uint32 width = SDL_SwapLE32(entry.width);
+			Uint32 height = SDL_SwapLE32(entry.height);
+			Uint32 pitch = SDL_SwapLE32(entry.pitch);
+			Uint64 data_offset = SDL_SwapLE64(entry.data_offset);
+
+			if (name_offset >= size
+			 || std::memchr(base + name_offset, '\0', size - name_offset) == nullptr) {
+				return false;
+			}
+
+			if (width > SDL_MAX_SINT32
+			 || height > SDL_MAX_SINT32
+			 || pitch > SDL_MAX_SINT32
+			 || pitch < width * bytes_per_pixel
+			 || data_offset > size
+			 || Uint64(pitch) * height > size - data_offset) {
+				return false;
+			}
+
+			const char *name = reinterpret_cast<const char *>(base + name_offset);
+			images[name] = { int(width), int(height), int(pitch), base + data_offset };
+		}
+
+		return true;
+	}
+};
+
+//
+// The pack object
+//
+
+static void spn_SDL_AssetPack_dtor(void *obj)
+{
+	spn_SDL_AssetPack *pack = static_cast<spn_SDL_AssetPack *>(obj);
+	delete pack->pack;
+}
+
+const SpnClass spn_SDL_AssetPack_class = {
+	sizeof(spn_SDL_AssetPack),
+	SPN_SDL_CLASS_UID_ASSET_PACK,
+	NULL,
+	NULL,
+	NULL,
+	spn_SDL_AssetPack_dtor
+};
+
+spn_SDL_AssetPack *spnlib_sdl2_assetpack_open(const char *filename)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+
+	void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping stays valid
+
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+
+	AssetPack *pack = new AssetPack(data, st.st_size);
+
+	if (!pack->parse()) {
+		delete pack;
+		return NULL;
+	}
+
+	spn_SDL_AssetPack *obj = static_cast<spn_SDL_AssetPack *>(
+		spn_object_new(&spn_SDL_AssetPack_class)
+	);
+
+	obj->pack = pack;
+	return obj;
+}
+
+// Maps an asset pack into memory. Returns nil if the file can't be
+// opened or isn't an asset pack.
+// Parameters:
+// 0. the file name of the pack
+int spnlib_SDL_OpenAssetPack(SpnValue *ret, int argc, SpnValue *argv, void *context)
+{
+	// C++ doesn't convert 'void *' implicitly, as the macros would need
+	SpnContext *ctx = static_cast<SpnContext *>(context);
+
+	CHECK_ARG_RETURN_ON_ERROR(0, string);
+
+	spn_SDL_AssetPack *pack = spnlib_sdl2_assetpack_open(STRARG(0));
+
+	if (pack) {
+		*ret = spn_makestrguserinfo(pack);
+	}
+
+	return 0;
+}
+
+spn_SDL_Texture *spnlib_sdl2_assetpack_load(
+	SDL_Renderer *renderer,
+	spn_SDL_AssetPack *pack,
+	const char *name
+)
+{
+	auto it = pack->pack->images.find(name);
+	if (it == pack->pack->images.end()) {
+		return NULL;
+	}
+
+	const AssetPack::Image &image = it->second;
+	Uint32 format = pack->pack->format;
+
+	SDL_Texture *texture = SDL_CreateTexture(
+		renderer,
+		format,
+		SDL_TEXTUREACCESS_STATIC,
+		image.width,
+		image.height
+	);
+
+	if (texture) {
+		// pages of the mapping are read in by the driver as it copies them
+		SDL_UpdateTexture(texture, NULL, image.pixels, image.pitch);
+		SDL_SetTextureBlendMode(
+			texture,
+			SDL_ISPIXELFORMAT_ALPHA(format) ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE
+		);
+	}
+
+	return spnlib_SDL_texture_new(texture);
+}
+
+//
+// Writing packs
+//
+
+static Uint64 align_offset(Uint64 offset)
+{
+	return (offset + SPN_SDL_PACK_ALIGNMENT - 1) / SPN_SDL_PACK_ALIGNMENT * SPN_SDL_PACK_ALIGNMENT;
+}
+
+static void write_padding(std::ofstream &file, Uint64 offset)
+{
+	static const char zeros[SPN_SDL_PACK_ALIGNMENT] = { 0 };
+	file.write(zeros, align_offset(offset) - offset);
+}
+
+bool spnlib_sdl2_assetpack_write(
+	const char *filename,
+	Uint32 format,
+	const char *const *names,
+	SDL_Surface *const *surfaces,
+	size_t count
+)
+{
+	std::size_t bytes_per_pixel = SDL_BYTESPERPIXEL(format);
+
+	SPN_SDL_PackHeader header;
+	std::memset(&header, 0, sizeof header);
+	std::memcpy(header.magic, SPN_SDL_PACK_MAGIC, sizeof SPN_SDL_PACK_MAGIC);
+	header.version = SDL_SwapLE32(SPN_SDL_PACK_VERSION);
+	header.format = SDL_SwapLE32(format);
+	header.count = SDL_SwapLE32(Uint32(count));
+
+	// lay out the names, then the pixels
+	Uint64 offset = sizeof header + count * sizeof(SPN_SDL_PackEntry);
+	std::vector<SPN_SDL_PackEntry> entries(count);
+
+	for (std::size_t i = 0; i < count; i++) {
+		if (surfaces[i]->format->format != format) {
+			return false;
+		}
+
+		entries[i].name_offset = SDL_SwapLE32(Uint32(offset));
+		offset += std::strlen(names[i]) + 1;
+	}
+
+	if (offset > SDL_MAX_UINT32) {
+		return false;
+	}
+
+	Uint64 names_end = offset;
+
+	for (std::size_t i = 0; i < count; i++) {
+		const SDL_Surface *surface = surfaces[i];
+		Uint32 pitch = Uint32(surface->w * bytes_per_pixel);
+
+		offset = align_offset(offset);
+
+		entries[i].width = SDL_SwapLE32(Uint32(surface->w));
+		entries[i].height = SDL_SwapLE32(Uint32(surface->h));
+		entries[i].pitch = SDL_SwapLE32(pitch);
+		entries[i].data_offset = SDL_SwapLE64(offset);
+
+		offset += Uint64(pitch) * surface->h;
+	}
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char *>(&header), sizeof header);
+	file.write(reinterpret_cast<const char *>(entries.data()), count * sizeof entries[0]);
+
+	for (std::size_t i = 0; i < count; i++) {
+		file.write(names[i], std::strlen(names[i]) + 1);
+	}
+
+	offset = names_end;
+
+	for (std::size_t i = 0; i < count; i++) {
+		SDL_Surface *surface = surfaces[i];
+		std::size_t row_size = surface->w * bytes_per_pixel;
+
+		write_padding(file, offset);
+		offset = align_offset(offset);
+
+		SDL_LockSurface(surface);
+
+		// surface rows may be padded; rows in the pack are not
+		for (int y = 0; y < surface->h; y++) {
+			const char *row = static_cast<const char *>(surface->pixels) + y * surface->pitch;
+			file.write(row, row_size);
+		}
+
+		SDL_UnlockSurface(surface);
+
+		offset += row_size * surface->h;
+	}
+
+	file.close();
+	return !file.fail();
+}
@@ -0,0 +1,87 @@
+//
+// sdl2_assetpack.h
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#ifndef SPNLIB_SDL2_ASSETPACK_H
+#define SPNLIB_SDL2_ASSETPACK_H
+
+#include <stdbool.h>
+
+#include <spn/api.h>
+
+#include <SDL2/SDL.h>
+
+#include "sdl2_texture.h"
+
+// An asset pack holds images that have already been decoded and
+// converted to a texture format, so that they can be uploaded straight
+// from the memory-mapped file. Layout (all integers are little-endian):
+//
+// 1. a SPN_SDL_PackHeader
+// 2. 'count' SPN_SDL_PackEntry records
+// 3. the NUL-terminated names of the images
+// 4. the pixels of each image ('height' rows of 'pitch' bytes), each
+//    starting at a multiple of SPN_SDL_PACK_ALIGNMENT
+#define SPN_SDL_PACK_MAGIC     "SPNPACK"
+#define SPN_SDL_PACK_VERSION   1
+#define SPN_SDL_PACK_ALIGNMENT 16
+
+typedef struct SPN_SDL_PackHeader {
+	char magic[8]; // SPN_SDL_PACK_MAGIC, NUL-padded
+	Uint32 version;
+	Uint32 format; // SDL_PIXELFORMAT_* of every image
+	Uint32 count;
+	Uint32 reserved;
+} SPN_SDL_PackHeader;
+
+typedef struct SPN_SDL_PackEntry {
+	Uint32 name_offset; // from the beginning of the file
+	Uint32 width;
+	Uint32 height;
+	Uint32 pitch;
+	Uint64 data_offset; // from the beginning of the file
+} SPN_SDL_PackEntry;
+
+struct AssetPack;
+
+typedef struct spn_SDL_AssetPack {
+	SpnObject base;
+	struct AssetPack *pack;
+} spn_SDL_AssetPack;
+
+SPN_API const SpnClass spn_SDL_AssetPack_class;
+
+// Maps 'filename' into memory and reads its index. The mapping is kept
+// until the returned object is deallocated. Returns a new reference,
+// or NULL if the file can't be mapped or isn't a valid pack.
+SPN_API spn_SDL_AssetPack *spnlib_sdl2_assetpack_open(const char *filename);
+
+// SDL::OpenAssetPack()
+SPN_API int spnlib_SDL_OpenAssetPack(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+
+// Creates a texture from the image called 'name', uploading the pixels
+// from the mapping without decoding or copying them. The texture is in
+// the format of the pack; packs made in the preferred format of
+// 'renderer' need no conversion by the driver either.
+// Returns NULL if there's no such image.
+SPN_API spn_SDL_Texture *spnlib_sdl2_assetpack_load(
+	SDL_Renderer *renderer,
+	spn_SDL_AssetPack *pack,
+	const char *name
+);
+
+// Writes a pack containing 'count' images to 'filename'. Every surface
+// must be in 'format' (see spnlib_sdl2_decode_image()).
+// Returns false if the file couldn't be written.
+SPN_API bool spnlib_sdl2_assetpack_write(
+	const char *filename,
+	Uint32 format,
+	const char *const *names,
+	SDL_Surface *const *surfaces,
+	size_t count
+);
+
+#endif // SPNLIB_SDL2_ASSETPACK_H
@@ -0,0 +1,576 @@
+//
+// sdl2_bmfont.cpp
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#include "sdl2_bmfont.h"
+#include "sdl2_sparkling.h"
+#include "sdl2_image.h"
+#include "sdl2_text_layout.h"
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+
+struct BitmapFont : public TextMetrics {
+	struct Char {
+		SDL_Rect rect; // location within the page
+		int xoffset, yoffset; // of the image relative to the pen position
+		int xadvance;
+		int page;
+	};
+
+	SDL_Renderer *renderer;
+	SpnObject *window; // owns 'renderer'; NULL once the window is gone
+	bool owns_window; // whether 'window' is retained
+	std::vector<spn_SDL_Texture *> pages; // retained; not shared, since they're tinted
+	std::unordered_map<Uint32, Char> chars;
+	std::unordered_map<Uint64, int> kernings; // by (first << 32 | second)
+	int line_height;
+
+	// drawn in place of missing characters
+	const Char *fallback;
+
+	BitmapFont(SDL_Renderer *rend, SpnObject *win) :
+		renderer(rend),
+		window(win),
+		owns_window(true),
+		line_height(0),
+		fallback(nullptr)
+	{
+		spn_object_retain(window);
+	}
+
+	~BitmapFont()
+	{
+		release_pages();
+
+		if (window && owns_window) {
+			spn_object_release(window);
+		}
+	}
+
+	void release_pages()
+	{
+		for (spn_SDL_Texture *page : pages) {
+			spn_object_release(page);
+		}
+
+		pages.clear();
+	}
+
+	void add_kerning(Uint32 first, Uint32 second, int amount)
+	{
+		kernings[Uint64(first) << 32 | second] = amount;
+	}
+
+	// Must be called once all characters have been added
+	void choose_fallback()
+	{
+		// BMFont uses the ID -1 for an explicit "invalid character" glyph
+		static const Uint32 candidates[] = { 0xffffffff, 0xfffd, '?' };
+
+		for (Uint32 cp : candidates) {
+			auto it = chars.find(cp);
+			if (it != chars.end()) {
+				fallback = &it->second;
+				return;
+			}
+		}
+	}
+
+	const Char *find(Uint32 cp) const
+	{
+		auto it = chars.find(cp);
+		return it != chars.end() ? &it->second : fallback;
+	}
+
+	int advance(Uint32 cp) override
+	{
+		const Char *c = find(cp);
+		return c ? c->xadvance : 0;
+	}
+
+	int kern(Uint32 left, Uint32 right) override
+	{
+		if (left == 0 || kernings.empty()) {
+			return 0;
+		}
+
+		auto it = kernings.find(Uint64(left) << 32 | right);
+		return it != kernings.end() ? it->second : 0;
+	}
+
+	int line_skip() override
+	{
+		return line_height;
+	}
+
+	int height() override
+	{
+		return line_height;
+	}
+
+	// See GlyphAtlas::draw_line() in sdl2_glyph.cpp
+	const char *draw_line(
+		int x,
+		int y,
+		const char *text,
+		const char *end,
+		SDL_Color color,
+		int &tinted_page
+	)
+	{
+		int pen = x;
+		Uint32 prev = 0;
+
+		while (text < end) {
+			const char *next = text;
+			Uint32 cp = spnlib_sdl2_utf8_next(&next);
+
+			if (cp == 0 || cp == '\n') {
+				break;
+			}
+
+			text = next;
+			pen += kern(prev, cp);
+			prev = cp;
+
+			const Char *c = find(cp);
+			if (c == nullptr) {
+				continue;
+			}
+
+			if (c->rect.w > 0 && c->rect.h > 0) {
+				SDL_Texture *page = pages[c->page]->texture;
+
+				// consecutive glyphs are usually on the same page
+				if (c->page != tinted_page) {
+					SDL_SetTextureColorMod(page, color.r, color.g, color.b);
+					SDL_SetTextureAlphaMod(page, color.a);
+					tinted_page = c->page;
+				}
+
+				SDL_Rect dst = { pen + c->xoffset, y + c->yoffset, c->rect.w, c->rect.h };
+				SDL_RenderCopy(renderer, page, &c->rect, &dst);
+			}
+
+			pen += c->xadvance;
+		}
+
+		return text;
+	}
+};
+
+//
+// Parsing BMFont descriptors
+// (see http://www.angelcode.com/products/bmfont/doc/file_format.html)
+//
+
+// The binary format stores the page of a character in a byte, so
+// descriptors declaring more pages than this are considered malformed
+static const int max_pages = 256;
+
+// The part of a descriptor that is common to both formats
+struct FontDescriptor {
+	int line_height;
+	std::vector<std::string> page_files; // by page ID
+	std::vector<std::pair<Uint32, BitmapFont::Char>> chars;
+	std::vector<std::pair<std::pair<Uint32, Uint32>, int>> kernings;
+
+	FontDescriptor() : line_height(0) {}
+};
+
+// Each line of the text format is a tag followed by key=value pairs.
+// Values are either numbers, comma-separated lists or quoted strings.
+static std::string parse_line(const std::string &line, std::unordered_map<std::string, std::string> &attrs)
+{
+	std::size_t i = 0, n = line.size();
+
+	auto skip_spaces = [&] {
+		while (i < n && std::isspace(static_cast<unsigned char>(line[i]))) {
+			i++;
+		}
+	};
+
+	auto read_until = [&](const char *delimiters) {
+		std::size_t begin = i;
+		while (i < n && !std::isspace(static_cast<unsigned char>(line[i])) && !std::strchr(delimiters, line[i])) {
+			i++;
+		}
+		return line.substr(begin, i - begin);
+	};
+
+	skip_spaces();
+	std::string tag = read_until("");
+
+	while (skip_spaces(), i < n) {
+		std::string key = read_until("=");
+
+		if (i >= n || line[i] != '=') {
+			continue;
+		}
+
+		i++; // skip '='
+
+		if (i < n && line[i] == '"') {
+			std::size_t close = line.find('"', i + 1);
+			if (close == std::string::npos) {
+				close = n;
+			}
+
+			attrs[key] = line.substr(i + 1, close - i - 1);
+			i = close + 1;
+		} else {
+			attrs[key] = read_until("");
+		}
+	}
+
+	return tag;
+}
+
+static int int_attr(const std::unordered_map<std::string, std::string> &attrs, const char *key)
+{
+	auto it = attrs.find(key);
+	return it != attrs.end() ? std::atoi(it->second.c_str()) : 0;
+}
+
+static bool parse_text(const std::string &data, FontDescriptor &desc)
+{
+	std::size_t pos = 0;
+	bool has_common = false;
+
+	while (pos < data.size()) {
+		std::size_t eol = data.find('\n', pos);
+		if (eol == std::string::npos) {
+			eol = data.size();
+		}
+
+		std::unordered_map<std::string, std::string> attrs;
+		std::string tag = parse_line(data.substr(pos, eol - pos), attrs);
+		pos = eol + 1;
+
+		if (tag == "common") {
+			int pages = int_attr(attrs, "pages");
+			if (pages < 0 || pages > max_pages) {
+				return false;
+			}
+
+			desc.line_height = int_attr(attrs, "lineHeight");
+			desc.page_files.resize(pages);
+			has_common = true;
+		} else if (tag == "page") {
+			int id = int_attr(attrs, "id");
+			if (id < 0 || id >= int(desc.page_files.size())) {
+				return false;
+			}
+
+			desc.page_files[id] = attrs["file"];
+		} else if (tag == "char") {
+			BitmapFont::Char c;
+			c.rect.x = int_attr(attrs, "x");
+			c.rect.y = int_attr(attrs, "y");
+			c.rect.w = int_attr(attrs, "width");
+			c.rect.h = int_attr(attrs, "height");
+			c.xoffset = int_attr(attrs, "xoffset");
+			c.yoffset = int_attr(attrs, "yoffset");
+			c.xadvance = int_attr(attrs, "xadvance");
+			c.page = int_attr(attrs, "page");
+
+			desc.chars.push_back({ Uint32(int_attr(attrs, "id")), c });
+		} else if (tag == "kerning") {
+			Uint32 first = int_attr(attrs, "first");
+			Uint32 second = int_attr(attrs, "second");
+			desc.kernings.push_back({ { first, second }, int_attr(attrs, "amount") });
+		}
+	}
+
+	return has_common;
+}
+
+// The binary format is little-endian
+static Uint32 read_le(const unsigned char *p, int size)
+{
+	Uint32 value = 0;
+
+	for (int i = size - 1; i >= 0; i--) {
+		value = value << 8 | p[i];
+	}
+
+	return value;
+}
+
+static bool parse_binary(const std::string &data, FontDescriptor &desc)
+{
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(data.data());
+	std::size_t n = data.size();
+
+	// "BMF" followed by the version number
+	if (n < 4 || p[3] != 3) {
+		return false;
+	}
+
+	bool has_common = false;
+	std::size_t pos = 4;
+
+	// blocks: 1-byte type, 4-byte size, contents
+	while (pos + 5 <= n) {
+		int type = p[pos];
+		std::size_t size = read_le(p + pos + 1, 4);
+		const unsigned char *block = p + pos + 5;
+		pos += 5;
+
+		if (size > n - pos) {
+			return false;
+		}
+
+		pos += size;
+
+		switch (type) {
+		case 2: { // common
+			if (size < 10) {
+				return false;
+			}
+
+			Uint32 pages = read_le(block + 8, 2);
+			if (pages > Uint32(max_pages)) {
+				return false;
+			}
+
+			desc.line_height = read_le(block, 2);
+			desc.page_files.resize(pages);
+			has_common = true;
+			break;
+		}
+		case 3: { // pages: NUL-terminated file names
+			std::size_t offset = 0;
+
+			for (std::string &file : desc.page_files) {
+				const char *name = reinterpret_cast<const char *>(block + offset);
+				const void *nul = std::memchr(name, 0, size - offset);
+				std::size_t len = nul ? static_cast<const char *>(nul) - name : size - offset;
+
+				file.assign(name, len);
+				offset += len + 1;
+
+				if (offset > size) {
+					break;
+				}
+			}
+
+			break;
+		}
+		case 4: // chars, 20 bytes each
+			for (std::size_t i = 0; i + 20 <= size; i += 20) {
+				const unsigned char *q = block + i;
+				BitmapFont::Char c;
+
+				c.rect.x = read_le(q + 4, 2);
+				c.rect.y = read_le(q + 6, 2);
+				c.rect.w = read_le(q + 8, 2);
+				c.rect.h = read_le(q + 10, 2);
+				c.xoffset = Sint16(read_le(q + 12, 2));
+				c.yoffset = Sint16(read_le(q + 14, 2));
+				c.xadvance = Sint16(read_le(q + 16, 2));
+				c.page = q[18];
+
+				desc.chars.push_back({ read_le(q, 4), c });
+			}
+
+			break;
+		case 5: // kerning pairs, 10 bytes each
+			for (std::size_t i = 0; i + 10 <= size; i += 10) {
+				const unsigned char *q = block + i;
+				desc.kernings.push_back({ { read_le(q, 4), read_le(q + 4, 4) }, Sint16(read_le(q + 8, 2)) });
+			}
+
+			break;
+		default:
+			break;
+		}
+	}
+
+	return has_common;
+}
+
+//
+// The font object
+//
+
+static void spn_SDL_BitmapFont_dtor(void *obj)
+{
+	spn_SDL_BitmapFont *font = static_cast<spn_SDL_BitmapFont *>(obj);
+	delete font->font;
+}
+
+const SpnClass spn_SDL_BitmapFont_class = {
+	sizeof(spn_SDL_BitmapFont),
+	SPN_SDL_CLASS_UID_BITMAP_FONT,
+	NULL,
+	NULL,
+	NULL,
+	spn_SDL_BitmapFont_dtor
+};
+
+spn_SDL_BitmapFont *spnlib_sdl2_bmfont_load(
+	SpnObject *window,
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const char *filename
+)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		return NULL;
+	}
+
+	std::string data {
+		std::istreambuf_iterator<char> { file },
+		std::istreambuf_iterator<char> {}
+	};
+
+	FontDescriptor desc;
+	bool binary = data.compare(0, 3, "BMF") == 0;
+
+	if (!(binary ? parse_binary(data, desc) : parse_text(data, desc))) {
+		return NULL;
+	}
+
+	std::unique_ptr<BitmapFont> font(new BitmapFont(renderer, window));
+	font->line_height = desc.line_height;
+
+	// page file names are relative to the descriptor
+	std::string path(filename);
+	std::size_t slash = path.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+
+	for (const std::string &page_file : desc.page_files) {
+		// not through the image cache: loadImage() of the same file
+		// mustn't return a texture tinted by the color of the text
+		SDL_Surface *surface = spnlib_sdl2_decode_image((directory + page_file).c_str(), format);
+		spn_SDL_Texture *page = spnlib_SDL_texture_new_surface(renderer, surface, format);
+
+		if (page == NULL || page->texture == NULL) {
+			if (page) {
+				spn_object_release(page);
+			}
+
+			return NULL;
+		}
+
+		SDL_SetTextureBlendMode(page->texture, SDL_BLENDMODE_BLEND);
+		font->pages.push_back(page);
+	}
+
+	for (const auto &c : desc.chars) {
+		if (c.second.page >= 0 && c.second.page < int(font->pages.size())) {
+			font->chars[c.first] = c.second;
+		}
+	}
+
+	for (const auto &k : desc.kernings) {
+		font->add_kerning(k.first.first, k.first.second, k.second);
+	}
+
+	font->choose_fallback();
+
+	spn_SDL_BitmapFont *obj = static_cast<spn_SDL_BitmapFont *>(
+		spn_object_new(&spn_SDL_BitmapFont_class)
+	);
+
+	obj->font = font.release();
+	return obj;
+}
+
+SpnObject *spnlib_sdl2_bmfont_window(spn_SDL_BitmapFont *font)
+{
+	return font->font->window;
+}
+
+void spnlib_sdl2_bmfont_release_window(spn_SDL_BitmapFont *font)
+{
+	BitmapFont &bmfont = *font->font;
+	assert(bmfont.owns_window);
+
+	bmfont.owns_window = false;
+	spn_object_release(bmfont.window);
+}
+
+void spnlib_sdl2_bmfont_retain_window(spn_SDL_BitmapFont *font)
+{
+	BitmapFont &bmfont = *font->font;
+	assert(!bmfont.owns_window);
+
+	bmfont.owns_window = true;
+	spn_object_retain(bmfont.window);
+}
+
+void spnlib_sdl2_bmfont_forget_window(spn_SDL_BitmapFont *font)
+{
+	BitmapFont &bmfont = *font->font;
+	assert(!bmfont.owns_window);
+
+	bmfont.release_pages();
+	bmfont.renderer = nullptr;
+	bmfont.window = nullptr;
+}
+
+void spnlib_sdl2_bmfont_draw_text(
+	spn_SDL_BitmapFont *font,
+	int x,
+	int y,
+	const char *text,
+	SDL_Color color
+)
+{
+	BitmapFont &bmfont = *font->font;
+	int tinted_page = -1;
+
+	draw_text_lines(x, y, text, bmfont.line_skip(), [&](int lx, int ly, const char *begin, const char *end) {
+		return bmfont.draw_line(lx, ly, begin, end, color, tinted_page);
+	});
+}
+
+int spnlib_sdl2_bmfont_text_width(spn_SDL_BitmapFont *font, const char *text)
+{
+	return font->font->width(text);
+}
+
+SPN_SDL_TextBoxSize spnlib_sdl2_bmfont_text_box_size(
+	spn_SDL_BitmapFont *font,
+	const char *text,
+	int wrap_width,
+	int line_height
+)
+{
+	return font->font->box_size(text, wrap_width, line_height);
+}
+
+void spnlib_sdl2_bmfont_draw_text_box(
+	spn_SDL_BitmapFont *font,
+	int x,
+	int y,
+	const char *text,
+	int wrap_width,
+	SPN_SDL_TextAlign align,
+	int line_height,
+	SDL_Color color
+)
+{
+	BitmapFont &bmfont = *font->font;
+	int tinted_page = -1;
+
+	draw_text_box(bmfont, x, y, text, wrap_width, align, line_height, [&](int lx, int ly, const char *begin, const char *end) {
+		return bmfont.draw_line(lx, ly, begin, end, color, tinted_page);
+	});
+}
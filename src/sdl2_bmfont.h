@@ -0,0 +1,87 @@
+//
+// sdl2_bmfont.h
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#ifndef SPNLIB_SDL2_BMFONT_H
+#define SPNLIB_SDL2_BMFONT_H
+
+#include <spn/api.h>
+
+#include <SDL2/SDL.h>
+
+#include "sdl2_glyph.h"
+
+struct BitmapFont;
+
+// A prerendered font: glyph images packed into one or more page
+// images, and the metrics of each glyph. Drawing one needs neither
+// FreeType nor rasterization, just copying from the page textures.
+typedef struct spn_SDL_BitmapFont {
+	SpnObject base;
+	struct BitmapFont *font;
+} spn_SDL_BitmapFont;
+
+SPN_API const SpnClass spn_SDL_BitmapFont_class;
+
+// Loads an AngelCode BMFont descriptor ('.fnt' file) in either the
+// text or the binary (version 3) format. Page images are loaded using
+// spnlib_sdl2_load_image(), relative to the directory of 'filename'.
+// 'window' (the owner of 'renderer') is retained, since the page
+// textures belong to its renderer.
+// Returns a new reference, or NULL if the font can't be loaded.
+SPN_API spn_SDL_BitmapFont *spnlib_sdl2_bmfont_load(
+	SpnObject *window,
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const char *filename
+);
+
+// The window that owns the page textures of 'font', or NULL
+// if it has been deallocated (see spnlib_sdl2_bmfont_forget_window())
+SPN_API SpnObject *spnlib_sdl2_bmfont_window(spn_SDL_BitmapFont *font);
+
+// While a font is the font of its own window, the window keeps the font
+// alive, so the font must not keep the window alive in turn, or neither
+// would ever be deallocated. The window calls release_window() when it
+// starts using the font, and retain_window() when it stops using it.
+// If it is deallocated in the meantime, it calls forget_window() instead,
+// which frees the page textures; the font can't be used any more.
+SPN_API void spnlib_sdl2_bmfont_release_window(spn_SDL_BitmapFont *font);
+SPN_API void spnlib_sdl2_bmfont_retain_window(spn_SDL_BitmapFont *font);
+SPN_API void spnlib_sdl2_bmfont_forget_window(spn_SDL_BitmapFont *font);
+
+// The following functions are equivalent to the ones in sdl2_glyph.h
+// with the same name (without "bmfont"), but they use a bitmap font.
+// They draw using the renderer that the font was loaded with.
+SPN_API void spnlib_sdl2_bmfont_draw_text(
+	spn_SDL_BitmapFont *font,
+	int x,
+	int y,
+	const char *text,
+	SDL_Color color
+);
+
+SPN_API int spnlib_sdl2_bmfont_text_width(spn_SDL_BitmapFont *font, const char *text);
+
+SPN_API SPN_SDL_TextBoxSize spnlib_sdl2_bmfont_text_box_size(
+	spn_SDL_BitmapFont *font,
+	const char *text,
+	int wrap_width,
+	int line_height
+);
+
+SPN_API void spnlib_sdl2_bmfont_draw_text_box(
+	spn_SDL_BitmapFont *font,
+	int x,
+	int y,
+	const char *text,
+	int wrap_width,
+	SPN_SDL_TextAlign align,
+	int line_height,
+	SDL_Color color
+);
+
+#endif // SPNLIB_SDL2_BMFONT_H
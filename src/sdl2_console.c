@@ -0,0 +1,705 @@
+//
+// sdl2_console.c
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#include <string.h>
+
+#include "sdl2_console.h"
+#include "sdl2_sparkling.h"
+#include "sdl2_window.h"
+#include "sdl2_glyph.h"
+#include "helpers.h"
+
+/////////////////////////////////
+//   Console Class structure   //
+/////////////////////////////////
+
+// A grid of fixed-width character cells showing the last lines of the
+// text written to it. Writing only updates the cells; the visible grid
+// is painted into a cached texture when drawn, and only the rows that
+// changed (or scrolled into view) since the last frame are repainted.
+typedef struct spn_SDL_Console {
+	SpnObject base;
+	spn_SDL_Window *window; // retained, since the textures belong to its renderer
+	TTF_Font *font;
+	int style; // the font is shared, so its style is only set while painting
+
+	int cols, rows; // size of the visible grid
+	int cell_width, cell_height;
+
+	// Scrollback: a ring buffer of 'capacity' lines of 'cols' cells.
+	// Lines are numbered in the order they were started, and line n
+	// is stored in slot n % capacity. Lines [total - count, total)
+	// are kept; output goes to the last one.
+	SPN_SDL_Cell *cells;
+	bool *dirty; // per slot: changed since it was last painted
+	int capacity;
+	int count;
+	Uint64 total;
+
+	int column; // of the output position on the last line
+	Uint32 color; // of text written subsequently, 0xRRGGBBAA
+	SDL_Color background;
+	int scroll; // number of lines the view is scrolled back by
+
+	// The visible grid is painted into targets[front]. When the view
+	// moves by less than its height, the painted rows are copied into
+	// the other texture, shifted, and the two textures swap roles.
+	bool use_targets; // false if the renderer can't render to textures
+	SDL_Texture *targets[2];
+	int front;
+	Uint64 painted_top; // line shown in the first row of targets[front]
+	bool painted; // false if targets[front] has to be repainted entirely
+
+	// links of the list of all consoles
+	struct spn_SDL_Console *prev, *next;
+} spn_SDL_Console;
+
+static spn_SDL_Console *consoles = NULL;
+
+// tab stops are this many columns apart
+static const int tab_width = 8;
+
+static SPN_SDL_Cell *console_line(spn_SDL_Console *console, Uint64 line)
+{
+	return console->cells + (line % console->capacity) * console->cols;
+}
+
+static bool *console_dirty(spn_SDL_Console *console, Uint64 line)
+{
+	return &console->dirty[line % console->capacity];
+}
+
+static int console_max_scroll(spn_SDL_Console *console)
+{
+	return console->count > console->rows ? console->count - console->rows : 0;
+}
+
+// Line shown in the first row of the grid
+static Uint64 console_top(spn_SDL_Console *console)
+{
+	int shown = console->rows + console->scroll;
+	return console->total - (console->count < shown ? console->count : shown);
+}
+
+// Starts a new line, dropping the oldest one if the scrollback is full
+static void console_new_line(spn_SDL_Console *console)
+{
+	console->total++;
+
+	if (console->count < console->capacity) {
+		console->count++;
+	}
+
+	Uint64 line = console->total - 1;
+	memset(console_line(console, line), 0, console->cols * sizeof(SPN_SDL_Cell));
+	*console_dirty(console, line) = true;
+	console->column = 0;
+
+	// keep showing the same lines while scrolled back
+	if (console->scroll > 0) {
+		int max_scroll = console_max_scroll(console);
+		console->scroll = console->scroll < max_scroll ? console->scroll + 1 : max_scroll;
+	}
+}
+
+static void console_put(spn_SDL_Console *console, Uint32 cp)
+{
+	if (console->column == console->cols) {
+		console_new_line(console);
+	}
+
+	Uint64 line = console->total - 1;
+	SPN_SDL_Cell *cell = &console_line(console, line)[console->column++];
+	cell->cp = cp;
+	cell->color = console->color;
+	*console_dirty(console, line) = true;
+}
+
+static void console_write(spn_SDL_Console *console, const char *text)
+{
+	Uint32 cp;
+
+	while ((cp = spnlib_sdl2_utf8_next(&text)) != 0) {
+		switch (cp) {
+		case '\n':
+			console_new_line(console);
+			break;
+		case '\r':
+			console->column = 0;
+			break;
+		case '\t': {
+			int stop = (console->column / tab_width + 1) * tab_width;
+			if (stop > console->cols) {
+				stop = console->cols;
+			}
+
+			while (console->column < stop) {
+				console_put(console, ' ');
+			}
+
+			break;
+		}
+		default:
+			// other control characters have no glyphs
+			if (cp >= ' ') {
+				console_put(console, cp);
+			}
+			break;
+		}
+	}
+}
+
+static void console_release_targets(spn_SDL_Console *console)
+{
+	for (int i = 0; i < 2; i++) {
+		if (console->targets[i]) {
+			SDL_DestroyTexture(console->targets[i]);
+			console->targets[i] = NULL;
+		}
+	}
+
+	console->painted = false;
+}
+
+static bool console_create_targets(spn_SDL_Console *console)
+{
+	spn_SDL_Window *window = console->window;
+
+	for (int i = 0; i < 2; i++) {
+		console->targets[i] = SDL_CreateTexture(
+			window->renderer,
+			window->format,
+			SDL_TEXTUREACCESS_TARGET,
+			console->cols * console->cell_width,
+			console->rows * console->cell_height
+		);
+
+		if (console->targets[i] == NULL) {
+			console_release_targets(console);
+			return false;
+		}
+
+		SDL_SetTextureBlendMode(console->targets[i], SDL_BLENDMODE_BLEND);
+	}
+
+	console->front = 0;
+	console->painted = false;
+
+	return true;
+}
+
+// Paints 'line' into 'row' of the current render target at (x, y).
+// Rows below the last line are only filled with the background.
+static void console_paint_row(spn_SDL_Console *console, int x, int y, int row, Uint64 line)
+{
+	spn_SDL_Window *window = console->window;
+	SDL_Color bg = console->background;
+
+	SDL_Rect rect = {
+		x,
+		y + row * console->cell_height,
+		console->cols * console->cell_width,
+		console->cell_height
+	};
+
+	SDL_SetRenderDrawColor(window->renderer, bg.r, bg.g, bg.b, bg.a);
+	SDL_RenderFillRect(window->renderer, &rect);
+
+	if (line < console->total) {
+		spnlib_sdl2_draw_cells(
+			window->renderer,
+			window->format,
+			console->font,
+			rect.x,
+			rect.y,
+			console->cell_width,
+			console_line(console, line),
+			console->cols
+		);
+
+		*console_dirty(console, line) = false;
+	}
+}
+
+// Brings targets[front] up to date with the visible lines
+static void console_update_targets(spn_SDL_Console *console, Uint64 top)
+{
+	SDL_Renderer *renderer = console->window->renderer;
+	int rows = console->rows;
+
+	// rows in [exposed_begin, exposed_end) don't show
+	// the right lines, regardless of the dirty flags
+	int exposed_begin = 0, exposed_end = rows;
+	bool scrolled = false;
+
+	if (console->painted) {
+		Sint64 delta = (Sint64)(top - console->painted_top);
+
+		if (delta == 0) {
+			exposed_end = 0;
+		} else if (delta > -rows && delta < rows) {
+			scrolled = true;
+
+			if (delta > 0) {
+				exposed_begin = rows - delta;
+			} else {
+				exposed_end = -delta;
+			}
+		}
+	}
+
+	bool needs_paint = exposed_begin < exposed_end;
+
+	for (int row = 0; row < rows && !needs_paint; row++) {
+		Uint64 line = top + row;
+		needs_paint = line < console->total && *console_dirty(console, line);
+	}
+
+	if (!needs_paint) {
+		return;
+	}
+
+	SDL_Texture *saved_target = SDL_GetRenderTarget(renderer);
+	SDL_BlendMode saved_mode;
+	Uint8 r, g, b, a;
+	SDL_GetRenderDrawBlendMode(renderer, &saved_mode);
+	SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+
+	if (scrolled) {
+		SDL_Texture *src_texture = console->targets[console->front];
+		SDL_Texture *dst_texture = console->targets[!console->front];
+		int kept = rows - (exposed_end - exposed_begin);
+		int w = console->cols * console->cell_width;
+		int h = kept * console->cell_height;
+
+		SDL_Rect src = { 0, 0, w, h };
+		SDL_Rect dst = { 0, 0, w, h };
+
+		if (exposed_begin > 0) {
+			src.y = (rows - kept) * console->cell_height; // scrolled down
+		} else {
+			dst.y = (rows - kept) * console->cell_height; // scrolled up
+		}
+
+		// copy pixels as they are, including alpha
+		SDL_SetRenderTarget(renderer, dst_texture);
+		SDL_SetTextureBlendMode(src_texture, SDL_BLENDMODE_NONE);
+		SDL_RenderCopy(renderer, src_texture, &src, &dst);
+		SDL_SetTextureBlendMode(src_texture, SDL_BLENDMODE_BLEND);
+
+		console->front = !console->front;
+	} else {
+		SDL_SetRenderTarget(renderer, console->targets[console->front]);
+	}
+
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+	int saved_style = TTF_GetFontStyle(console->font);
+	if (saved_style != console->style) {
+		TTF_SetFontStyle(console->font, console->style);
+	}
+
+	for (int row = 0; row < rows; row++) {
+		Uint64 line = top + row;
+		bool exposed = row >= exposed_begin && row < exposed_end;
+
+		if (exposed || (line < console->total && *console_dirty(console, line))) {
+			console_paint_row(console, 0, 0, row, line);
+		}
+	}
+
+	if (saved_style != console->style) {
+		TTF_SetFontStyle(console->font, saved_style);
+	}
+
+	SDL_SetRenderTarget(renderer, saved_target);
+	SDL_SetRenderDrawBlendMode(renderer, saved_mode);
+	SDL_SetRenderDrawColor(renderer, r, g, b, a);
+
+	console->painted_top = top;
+	console->painted = true;
+}
+
+// Used if the renderer can't render to textures
+static void console_draw_directly(spn_SDL_Console *console, int x, int y, Uint64 top)
+{
+	SDL_Renderer *renderer = console->window->renderer;
+
+	SDL_BlendMode saved_mode;
+	Uint8 r, g, b, a;
+	SDL_GetRenderDrawBlendMode(renderer, &saved_mode);
+	SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+	int saved_style = TTF_GetFontStyle(console->font);
+	if (saved_style != console->style) {
+		TTF_SetFontStyle(console->font, console->style);
+	}
+
+	for (int row = 0; row < console->rows; row++) {
+		console_paint_row(console, x, y, row, top + row);
+	}
+
+	if (saved_style != console->style) {
+		TTF_SetFontStyle(console->font, saved_style);
+	}
+
+	SDL_SetRenderDrawBlendMode(renderer, saved_mode);
+	SDL_SetRenderDrawColor(renderer, r, g, b, a);
+}
+
+static void console_draw(spn_SDL_Console *console, int x, int y)
+{
+	Uint64 top = console_top(console);
+
+	if (console->use_targets && console->targets[0] == NULL) {
+		console->use_targets = console_create_targets(console);
+	}
+
+	if (!console->use_targets) {
+		console_draw_directly(console, x, y, top);
+		return;
+	}
+
+	console_update_targets(console, top);
+
+	SDL_Rect dst = {
+		x,
+		y,
+		console->cols * console->cell_width,
+		console->rows * console->cell_height
+	};
+
+	SDL_RenderCopy(console->window->renderer, console->targets[console->front], NULL, &dst);
+}
+
+static void spn_SDL_Console_dtor(void *o)
+{
+	spn_SDL_Console *console = o;
+
+	if (console->prev) {
+		console->prev->next = console->next;
+	} else {
+		consoles = console->next;
+	}
+
+	if (console->next) {
+		console->next->prev = console->prev;
+	}
+
+	console_release_targets(console);
+	SDL_free(console->cells);
+	SDL_free(console->dirty);
+	spn_object_release(console->window);
+}
+
+static const SpnClass spn_SDL_Console_class = {
+	sizeof(spn_SDL_Console),
+	SPN_SDL_CLASS_UID_CONSOLE,
+	NULL,
+	NULL,
+	NULL,
+	spn_SDL_Console_dtor
+};
+
+static spn_SDL_Console *console_from_hashmap(SpnHashMap *hm)
+{
+	SpnValue objv = spn_hashmap_get_strkey(hm, "console");
+
+	if (!spn_isstrguserinfo(&objv)) {
+		return NULL;
+	}
+
+	spn_SDL_Console *console = spn_objvalue(&objv);
+
+	if (!spn_object_member_of_class(console, &spn_SDL_Console_class)) {
+		return NULL;
+	}
+
+	return console;
+}
+
+#define CHECK_FOR_CONSOLE_HASHMAP(argnum)                                  \
+	CHECK_ARG_RETURN_ON_ERROR(argnum, hashmap);                            \
+	spn_SDL_Console *console = console_from_hashmap(HASHMAPARG(argnum));   \
+	if (console == NULL) {                                                 \
+		spn_ctx_runtime_error(ctx, "console object is invalid", NULL);     \
+		return -1;                                                         \
+	}
+
+/////////////////////////////////
+//   Initialize Console Class  //
+/////////////////////////////////
+
+// Creates a console using the current font and drawing color of the
+// window. Cells are as wide as the letter 'M', so a monospace font
+// should be used.
+// Parameters:
+// 0. the window object
+// 1. number of columns
+// 2. number of rows
+// 3. (optional) number of lines to keep, including the visible ones
+//    (default: 1000)
+int spnlib_SDL_Window_createConsole(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+
+	spn_SDL_Window *window = window_from_hashmap(HASHMAPARG(0));
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	if (window->font == NULL) {
+		const char *msg = window->bitmap_font
+		                ? "consoles need a TrueType font, not a bitmap font"
+		                : "no font set; call setFont() first";
+		spn_ctx_runtime_error(ctx, msg, NULL);
+		return -2;
+	}
+
+	double cols = NUMARG(1);
+	double rows = NUMARG(2);
+	double lines = 1000;
+
+	if (argc > 3) {
+		CHECK_ARG_RETURN_ON_ERROR(3, number);
+		lines = NUMARG(3);
+	}
+
+	if (lines < rows) {
+		lines = rows;
+	}
+
+	if (cols < 1 || rows < 1 || cols * lines > 64 * 1024 * 1024) {
+		spn_ctx_runtime_error(ctx, "invalid console size", NULL);
+		return -3;
+	}
+
+	SPN_SDL_Cell *cells = SDL_calloc((size_t)cols * (size_t)lines, sizeof cells[0]);
+	bool *dirty = SDL_calloc((size_t)lines, sizeof dirty[0]);
+
+	if (cells == NULL || dirty == NULL) {
+		SDL_free(cells);
+		SDL_free(dirty);
+		spn_ctx_runtime_error(ctx, "out of memory for console", NULL);
+		return -4;
+	}
+
+	spn_SDL_Console *console = spn_object_new(&spn_SDL_Console_class);
+
+	spn_object_retain(window);
+	console->window = window;
+	console->font = window->font;
+	console->style = TTF_GetFontStyle(window->font);
+
+	console->cols = cols;
+	console->rows = rows;
+	console->cell_width = spnlib_sdl2_glyph_advance(window->font, 'M');
+	console->cell_height = TTF_FontLineSkip(window->font);
+
+	console->cells = cells;
+	console->dirty = dirty;
+	console->capacity = lines;
+	console->count = 0;
+	console->total = 0;
+
+	SDL_Color color;
+	SDL_GetRenderDrawColor(window->renderer, &color.r, &color.g, &color.b, &color.a);
+	console->color = (Uint32)color.r << 24 | (Uint32)color.g << 16 | (Uint32)color.b << 8 | color.a;
+	console->background = (SDL_Color){ 0, 0, 0, 255 };
+	console->scroll = 0;
+
+	console->use_targets = SDL_RenderTargetSupported(window->renderer);
+	console->targets[0] = console->targets[1] = NULL;
+	console->front = 0;
+	console->painted_top = 0;
+	console->painted = false;
+
+	console->prev = NULL;
+	console->next = consoles;
+	if (consoles) {
+		consoles->prev = console;
+	}
+	consoles = console;
+
+	console_new_line(console);
+
+	// construct return value
+	*ret = spn_makehashmap();
+	SpnHashMap *hm = spn_hashmapvalue(ret);
+
+	// set its prototype
+	SpnValue proto = spn_get_lib_prototype("Console");
+	spn_hashmap_set_strkey(hm, "super", &proto);
+
+	SpnValue consoleval = spn_makestrguserinfo(console);
+	spn_hashmap_set_strkey(hm, "console", &consoleval);
+	spn_value_release(&consoleval);
+
+	return 0;
+}
+
+void spnlib_SDL_console_release_textures(void)
+{
+	for (spn_SDL_Console *console = consoles; console; console = console->next) {
+		console_release_targets(console);
+	}
+}
+
+/////////////////////////////////
+//       Console methods       //
+/////////////////////////////////
+
+// Appends text to the console. Newline characters start a new line,
+// carriage returns move back to the start of the line, tabs advance to
+// the next multiple of 8 columns, and lines longer than the width of
+// the console are wrapped.
+// Parameters:
+// 0. the console object
+// 1. the text, as a string
+static int spnlib_SDL_Console_write(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_CONSOLE_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	console_write(console, STRARG(1));
+
+	return 0;
+}
+
+// Removes every line, including the scrollback
+static int spnlib_SDL_Console_clear(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_CONSOLE_HASHMAP(0);
+
+	console->count = 0;
+	console->scroll = 0;
+	console_new_line(console);
+	console->painted = false;
+
+	return 0;
+}
+
+// Sets the color of text written subsequently.
+// Same parameters as Window.setColor()
+static int spnlib_SDL_Console_setColor(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_CONSOLE_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+	CHECK_ARG_RETURN_ON_ERROR(3, number);
+	CHECK_ARG_RETURN_ON_ERROR(4, number);
+
+	Uint32 r = constrain_to_01(NUMARG(1)) * 255;
+	Uint32 g = constrain_to_01(NUMARG(2)) * 255;
+	Uint32 b = constrain_to_01(NUMARG(3)) * 255;
+	Uint32 a = constrain_to_01(NUMARG(4)) * 255;
+
+	console->color = r << 24 | g << 16 | b << 8 | a;
+
+	return 0;
+}
+
+// Same parameters as Window.setColor()
+static int spnlib_SDL_Console_setBackground(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_CONSOLE_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+	CHECK_ARG_RETURN_ON_ERROR(3, number);
+	CHECK_ARG_RETURN_ON_ERROR(4, number);
+
+	console->background = (SDL_Color){
+		constrain_to_01(NUMARG(1)) * 255,
+		constrain_to_01(NUMARG(2)) * 255,
+		constrain_to_01(NUMARG(3)) * 255,
+		constrain_to_01(NUMARG(4)) * 255
+	};
+
+	console->painted = false;
+
+	return 0;
+}
+
+// Scrolls the view back into the scrollback. Returns the number of
+// lines it is actually scrolled back by (the argument is clamped).
+// Parameters:
+// 0. the console object
+// 1. number of lines, 0 shows the last lines
+static int spnlib_SDL_Console_scroll(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_CONSOLE_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+
+	double lines = NUMARG(1);
+	int max_scroll = console_max_scroll(console);
+
+	console->scroll = lines < 0 ? 0 : lines > max_scroll ? max_scroll : lines;
+	*ret = spn_makeint(console->scroll);
+
+	return 0;
+}
+
+// Returns a hashmap with keys "width" and "height" (in pixels),
+// "cols" and "rows" (in cells), and "lines" (number of lines kept)
+static int spnlib_SDL_Console_size(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_CONSOLE_HASHMAP(0);
+
+	*ret = spn_makehashmap();
+	SpnHashMap *size = spn_hashmapvalue(ret);
+
+	set_integer_property(size, "width", console->cols * console->cell_width);
+	set_integer_property(size, "height", console->rows * console->cell_height);
+	set_integer_property(size, "cols", console->cols);
+	set_integer_property(size, "rows", console->rows);
+	set_integer_property(size, "lines", console->count);
+
+	return 0;
+}
+
+// Draws the console in its window.
+// Parameters:
+// 0. the console object
+// 1. X coordinate of the top left corner
+// 2. Y coordinate of the top left corner
+static int spnlib_SDL_Console_draw(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_CONSOLE_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+
+	console_draw(console, NUMARG(1), NUMARG(2));
+
+	return 0;
+}
+
+/////////////////////////////////
+//   Console methods creation  //
+/////////////////////////////////
+void spnlib_SDL_methods_for_Console(SpnHashMap *console)
+{
+	static const SpnExtFunc methods[] = {
+		{ "write",         spnlib_SDL_Console_write         },
+		{ "clear",         spnlib_SDL_Console_clear         },
+		{ "setColor",      spnlib_SDL_Console_setColor      },
+		{ "setBackground", spnlib_SDL_Console_setBackground },
+		{ "scroll",        spnlib_SDL_Console_scroll        },
+		{ "size",          spnlib_SDL_Console_size          },
+		{ "draw",          spnlib_SDL_Console_draw          }
+	};
+
+	for (size_t i = 0; i < COUNT(methods); i++) {
+		SpnValue fnval = spn_makenativefunc(methods[i].name, methods[i].fn);
+		spn_hashmap_set_strkey(console, methods[i].name, &fnval);
+		spn_value_release(&fnval);
+	}
+}
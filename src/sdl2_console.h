@@ -0,0 +1,26 @@
+//
+// sdl2_console.h
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#ifndef SPNLIB_SDL2_CONSOLE_H
+#define SPNLIB_SDL2_CONSOLE_H
+
+#include <spn/ctx.h>
+#include <spn/api.h>
+
+#include <SDL2/SDL.h>
+
+// Window.createConsole(); argument #0 is the window object
+int spnlib_SDL_Window_createConsole(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+
+// Frees the cached textures of every console. They are
+// recreated and repainted entirely when next drawn.
+void spnlib_SDL_console_release_textures(void);
+
+// In order to bridge data between sdl2_sparkling.c and this file
+void spnlib_SDL_methods_for_Console(SpnHashMap *console);
+
+#endif // SPNLIB_SDL2_CONSOLE_H
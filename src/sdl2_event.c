@@ -8,49 +8,189 @@
 // Licensed under the 2-clause BSD License
 //
 
+#include <string.h>
+
 #include "sdl2_event.h"
+#include "sdl2_sparkling.h"
+#include "sdl2_label.h"
+#include "sdl2_console.h"
+#include "sdl2_tiled.h"
+#include "sdl2_image.h"
 #include "helpers.h"
 
 //
-// Helpers for 'event_to_hashmap()'
+// Polled events
 //
 
-static SpnValue flags_from_modifier(SDL_Keymod mod)
+// An SDL_Event along with the resources it refers to. These are taken
+// over when the event is polled, since some of them can only be dealt
+// with on the main thread, and the rest must be freed exactly once.
+typedef struct EventData {
+	SDL_Event event;
+	char *text; // owned; the file name of "drop" and "imageloaded" events
+	Uint32 id; // of "imageloaded" events
+	spn_SDL_Texture *image; // retained; the loaded image, or NULL
+	SpnObject *timer; // retained; the timer of "timer" events
+} EventData;
+
+static void event_data_init(EventData *data, const SDL_Event *event)
+{
+	data->event = *event;
+	data->text = NULL;
+	data->id = 0;
+	data->image = NULL;
+	data->timer = NULL;
+
+	switch (event->type) {
+	case SDL_DROPFILE:
+		data->text = event->drop.file;
+		break;
+	case SDL_USEREVENT:
+		switch (event->user.code) {
+		case SPN_SDL_USEREVENT_TIMER:
+			data->timer = event->user.data1;
+			spn_object_retain(data->timer);
+			break;
+		case SPN_SDL_USEREVENT_IMAGE_LOADED: {
+			SPN_SDL_ImageLoad *load = event->user.data1;
+			data->id = load->id;
+			data->text = SDL_strdup(load->filename);
+
+			// the texture is created here, on the main thread
+			data->image = spnlib_sdl2_finish_image_load(load);
+			break;
+		}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void event_data_free(EventData *data)
+{
+	SDL_free(data->text);
+
+	if (data->image) {
+		spn_object_release(data->image);
+	}
+
+	if (data->timer) {
+		spn_object_release(data->timer);
+	}
+}
+
+// Must be called for every event taken off the queue,
+// whether or not it is returned to the script
+static void event_housekeeping(const SDL_Event *event)
+{
+	// textures of labels and consoles can be re-rendered on demand
+	if (event->type == SDL_APP_LOWMEMORY) {
+		spnlib_SDL_label_release_textures();
+		spnlib_SDL_console_release_textures();
+		spnlib_SDL_tiled_release_textures();
+	}
+
+	// the contents of render targets are lost
+	if (event->type == SDL_RENDER_TARGETS_RESET || event->type == SDL_RENDER_DEVICE_RESET) {
+		spnlib_SDL_console_release_textures();
+	}
+
+	// every texture is lost; tiles are uploaded again on demand
+	if (event->type == SDL_RENDER_DEVICE_RESET) {
+		spnlib_SDL_tiled_release_textures();
+	}
+}
+
+// Polls the next event and takes care of the housekeeping it requires.
+// Returns false if there's no event to process.
+static bool poll_event(EventData *data)
+{
+	SDL_Event event;
+	if (!SDL_PollEvent(&event)) {
+		return false;
+	}
+
+	event_housekeeping(&event);
+	event_data_init(data, &event);
+	return true;
+}
+
+// Frees the resources of an event nobody asked for
+static void discard_event(const SDL_Event *event)
+{
+	// don't create a texture just to destroy it
+	if (event->type == SDL_USEREVENT
+	 && event->user.code == SPN_SDL_USEREVENT_IMAGE_LOADED) {
+		spnlib_sdl2_cancel_image_load(event->user.data1);
+		return;
+	}
+
+	EventData data;
+	event_data_init(&data, event);
+	event_data_free(&data);
+}
+
+//
+// Helpers for 'event_field()'
+//
+
+typedef struct EventFlag {
+	const char *name;
+	Uint32 mask;
+} EventFlag;
+
+static const EventFlag modifier_flags[] = {
+	{ "lshift",   KMOD_LSHIFT },
+	{ "rshift",   KMOD_RSHIFT },
+	{ "shift",    KMOD_SHIFT  }, // either of left or right shift
+	{ "lctrl",    KMOD_LCTRL  },
+	{ "rctrl",    KMOD_RCTRL  },
+	{ "ctrl",     KMOD_CTRL   }, // either of left or right control
+	{ "lalt",     KMOD_LALT   },
+	{ "ralt",     KMOD_RALT   },
+	{ "alt",      KMOD_ALT    }, // either of left or right alt
+	{ "lsuper",   KMOD_LGUI   },
+	{ "rsuper",   KMOD_RGUI   },
+	{ "super",    KMOD_GUI    }, // either of left or right Windows/Command
+	{ "numlock",  KMOD_NUM    },
+	{ "capslock", KMOD_CAPS   }
+};
+
+static const EventFlag mouse_button_flags[] = {
+	{ "left",   SDL_BUTTON_LMASK  },
+	{ "right",  SDL_BUTTON_RMASK  },
+	{ "middle", SDL_BUTTON_MMASK  },
+	{ "X1",     SDL_BUTTON_X1MASK },
+	{ "X2",     SDL_BUTTON_X2MASK }
+};
+
+// Builds a hashmap of Booleans, one for each of 'flags'
+static SpnValue hashmap_from_flags(const EventFlag *flags, size_t n, Uint32 mask)
 {
 	SpnValue ret = spn_makehashmap();
 	SpnHashMap *hm = spn_hashmapvalue(&ret);
 
-	struct {
-		const char *name;
-		int flag;
-	} flags[] = {
-		{ "lshift",   mod & KMOD_LSHIFT },
-		{ "rshift",   mod & KMOD_RSHIFT },
-		{ "shift",    mod & KMOD_SHIFT  }, // either of left or right shift
-		{ "lctrl",    mod & KMOD_LCTRL  },
-		{ "rctrl",    mod & KMOD_RCTRL  },
-		{ "ctrl",     mod & KMOD_CTRL   }, // either of left or right control
-		{ "lalt",     mod & KMOD_LALT   },
-		{ "ralt",     mod & KMOD_RALT   },
-		{ "alt",      mod & KMOD_ALT    }, // either of left or right alt
-		{ "lsuper",   mod & KMOD_LGUI   },
-		{ "rsuper",   mod & KMOD_RGUI   },
-		{ "super",    mod & KMOD_GUI    }, // either of left or right Windows/Command
-		{ "numlock",  mod & KMOD_NUM    },
-		{ "capslock", mod & KMOD_CAPS   }
-	};
-
-	for (size_t i = 0; i < sizeof flags / sizeof flags[0]; i++) {
-		spn_hashmap_set_strkey(
-			hm,
-			flags[i].name,
-			&(SpnValue){ .type = SPN_TYPE_BOOL, .v.b = !!flags[i].flag }
-		);
+	for (size_t i = 0; i < n; i++) {
+		SpnValue flag = spn_makebool((mask & flags[i].mask) != 0);
+		spn_hashmap_set_strkey(hm, flags[i].name, &flag);
 	}
 
 	return ret;
 }
 
+// Returns NULL if there's no flag called 'name'
+static const EventFlag *find_flag(const EventFlag *flags, size_t n, const char *name)
+{
+	for (size_t i = 0; i < n; i++) {
+		if (strcmp(flags[i].name, name) == 0) {
+			return &flags[i];
+		}
+	}
+
+	return NULL;
+}
+
 static const char *get_mouse_button_name(Uint8 button)
 {
 	switch (button) {
@@ -63,33 +203,6 @@ static const char *get_mouse_button_name(Uint8 button)
 	}
 }
 
-static SpnValue flags_from_mouse_button(Uint32 mask)
-{
-	SpnValue ret = spn_makehashmap();
-	SpnHashMap *hm = spn_hashmapvalue(&ret);
-
-	struct {
-		const char *name;
-		int flag;
-	} flags[] = {
-		{ "left",   mask & SDL_BUTTON_LMASK  },
-		{ "right",  mask & SDL_BUTTON_RMASK  },
-		{ "middle", mask & SDL_BUTTON_MMASK  },
-		{ "X2",     mask & SDL_BUTTON_X1MASK },
-		{ "X2",     mask & SDL_BUTTON_X2MASK }
-	};
-
-	for (size_t i = 0; i < sizeof flags / sizeof flags[0]; i++) {
-		spn_hashmap_set_strkey(
-			hm,
-			flags[i].name,
-			&(SpnValue){ .type = SPN_TYPE_BOOL, .v.b = !!flags[i].flag }
-		);
-	}
-
-	return ret;
-}
-
 static const char *get_window_event_name(SDL_WindowEventID value)
 {
 	switch (value) {
@@ -111,141 +224,283 @@ static const char *get_window_event_name(SDL_WindowEventID value)
 	}
 }
 
-// Converts an SDL_Event structure to an SpnHashMap object
-static SpnValue event_to_hashmap(SDL_Event *event)
+// The values of the "type" property
+typedef enum EventType {
+	TYPE_OTHER,
+	TYPE_KEYBOARD,
+	TYPE_MOUSEBUTTON,
+	TYPE_MOUSEMOVE,
+	TYPE_MOUSEWHEEL,
+	TYPE_TOUCHDOWN,
+	TYPE_TOUCHMOVE,
+	TYPE_TOUCHUP,
+	TYPE_GESTURE,
+	TYPE_QUIT,
+	TYPE_WINDOW,
+	TYPE_DROP,
+	TYPE_TIMER,
+	TYPE_IMAGELOADED,
+	TYPE_REPLAYFINISHED,
+	TYPE_COUNT
+} EventType;
+
+static const char *const event_type_names[TYPE_COUNT] = {
+	"",
+	"keyboard",
+	"mousebutton",
+	"mousemove",
+	"mousewheel",
+	"touchdown",
+	"touchmove",
+	"touchup",
+	"gesture",
+	"quit",
+	"window",
+	"drop",
+	"timer",
+	"imageloaded",
+	"replayfinished"
+};
+
+static EventType get_event_type(const SDL_Event *event)
 {
-	SpnValue ret = spn_makehashmap();
-	SpnHashMap *hm = spn_hashmapvalue(&ret);
-	const char *type = "";
-
 	switch (event->type) {
-	case SDL_KEYDOWN: // fallthru
-	case SDL_KEYUP: {
-		type = "keyboard";
-
-		set_string_property(hm, "value", SDL_GetKeyName(event->key.keysym.sym));
-
-		SpnValue mod = flags_from_modifier(event->key.keysym.mod);
-		spn_hashmap_set_strkey(hm, "modifier", &mod);
-		spn_value_release(&mod);
-
-		SpnValue state = spn_makebool(event->key.state == SDL_PRESSED);
-		spn_hashmap_set_strkey(hm, "state", &state);
-
-		break;
+	case SDL_KEYDOWN:         return TYPE_KEYBOARD;
+	case SDL_KEYUP:           return TYPE_KEYBOARD;
+	case SDL_MOUSEBUTTONDOWN: return TYPE_MOUSEBUTTON;
+	case SDL_MOUSEBUTTONUP:   return TYPE_MOUSEBUTTON;
+	case SDL_MOUSEMOTION:     return TYPE_MOUSEMOVE;
+	case SDL_MOUSEWHEEL:      return TYPE_MOUSEWHEEL;
+	case SDL_FINGERDOWN:      return TYPE_TOUCHDOWN;
+	case SDL_FINGERMOTION:    return TYPE_TOUCHMOVE;
+	case SDL_FINGERUP:        return TYPE_TOUCHUP;
+	case SDL_MULTIGESTURE:    return TYPE_GESTURE;
+	case SDL_QUIT:            return TYPE_QUIT;
+	case SDL_WINDOWEVENT:     return TYPE_WINDOW;
+	case SDL_DROPFILE:        return TYPE_DROP;
+	case SDL_USEREVENT:
+		switch (event->user.code) {
+		case SPN_SDL_USEREVENT_TIMER:           return TYPE_TIMER;
+		case SPN_SDL_USEREVENT_IMAGE_LOADED:    return TYPE_IMAGELOADED;
+		case SPN_SDL_USEREVENT_REPLAY_FINISHED: return TYPE_REPLAYFINISHED;
+		default:                                return TYPE_OTHER;
+		}
+	default:
+		return TYPE_OTHER;
 	}
-	case SDL_MOUSEBUTTONDOWN: // fallthru
-	case SDL_MOUSEBUTTONUP: {
-		type = "mousebutton";
-
-		const char *btnname = get_mouse_button_name(event->button.button);
-		set_string_property_nocopy(hm, "button", btnname);
-
-		SpnValue state = spn_makebool(event->button.state == SDL_PRESSED);
-		spn_hashmap_set_strkey(hm, "state", &state);
+}
 
-		set_integer_property(hm, "count", event->button.clicks);
-		set_integer_property(hm, "x", event->button.x);
-		set_integer_property(hm, "y", event->button.y);
+// The properties of events. Which of them an event has depends on its type.
+typedef enum EventField {
+	FIELD_TYPE,
+	FIELD_TIMESTAMP,
+	FIELD_VALUE,
+	FIELD_STATE,
+	FIELD_MODIFIER,
+	FIELD_MODIFIERS,
+	FIELD_BUTTON,
+	FIELD_COUNT,
+	FIELD_X,
+	FIELD_Y,
+	FIELD_DX,
+	FIELD_DY,
+	FIELD_BUTTONS,
+	FIELD_BUTTON_MASK,
+	FIELD_FINGER,
+	FIELD_PRESSURE,
+	FIELD_FINGER_COUNT,
+	FIELD_ROTATION,
+	FIELD_DISTANCE,
+	FIELD_ID,
+	FIELD_NAME,
+	FIELD_DATA1,
+	FIELD_DATA2,
+	FIELD_FILENAME,
+	FIELD_IMAGE
+} EventField;
+
+// The properties of the hashmaps returned by SDL::PollEvent()
+static const struct {
+	const char *name;
+	EventField field;
+} hashmap_fields[] = {
+	{ "type",        FIELD_TYPE         },
+	{ "timestamp",   FIELD_TIMESTAMP    },
+	{ "value",       FIELD_VALUE        },
+	{ "state",       FIELD_STATE        },
+	{ "modifier",    FIELD_MODIFIER     },
+	{ "button",      FIELD_BUTTON       },
+	{ "count",       FIELD_COUNT        },
+	{ "x",           FIELD_X            },
+	{ "y",           FIELD_Y            },
+	{ "dx",          FIELD_DX           },
+	{ "dy",          FIELD_DY           },
+	{ "buttons",     FIELD_BUTTONS      },
+	{ "finger",      FIELD_FINGER       },
+	{ "pressure",    FIELD_PRESSURE     },
+	{ "fingerCount", FIELD_FINGER_COUNT },
+	{ "rotation",    FIELD_ROTATION     },
+	{ "distance",    FIELD_DISTANCE     },
+	{ "ID",          FIELD_ID           },
+	{ "name",        FIELD_NAME         },
+	{ "data1",       FIELD_DATA1        },
+	{ "data2",       FIELD_DATA2        },
+	{ "filename",    FIELD_FILENAME     },
+	{ "image",       FIELD_IMAGE        }
+};
+
+// Returns the value of a property of an event as a new reference,
+// or nil if events of its type don't have such a property
+static SpnValue event_field(const EventData *data, EventField field)
+{
+	const SDL_Event *event = &data->event;
 
+	switch (field) {
+	case FIELD_TYPE:
+		return spn_makestring_nocopy(event_type_names[get_event_type(event)]);
+	case FIELD_TIMESTAMP:
+		return spn_makeint(event->common.timestamp);
+	default:
 		break;
 	}
-	case SDL_MOUSEMOTION: {
-		type = "mousemove";
-
-		set_integer_property(hm, "x", event->motion.x);
-		set_integer_property(hm, "y", event->motion.y);
-		set_integer_property(hm, "dx", event->motion.xrel);
-		set_integer_property(hm, "dy", event->motion.yrel);
-
-		SpnValue flags = flags_from_mouse_button(event->motion.state);
-		spn_hashmap_set_strkey(hm, "buttons", &flags);
-		spn_value_release(&flags);
 
+	switch (event->type) {
+	case SDL_KEYDOWN: // fallthru
+	case SDL_KEYUP:
+		switch (field) {
+		case FIELD_VALUE:     return spn_makestring(SDL_GetKeyName(event->key.keysym.sym));
+		case FIELD_STATE:     return spn_makebool(event->key.state == SDL_PRESSED);
+		case FIELD_MODIFIER:  return hashmap_from_flags(modifier_flags, COUNT(modifier_flags), event->key.keysym.mod);
+		case FIELD_MODIFIERS: return spn_makeint(event->key.keysym.mod);
+		default:              break;
+		}
+		break;
+	case SDL_MOUSEBUTTONDOWN: // fallthru
+	case SDL_MOUSEBUTTONUP:
+		switch (field) {
+		case FIELD_BUTTON: {
+			const char *btnname = get_mouse_button_name(event->button.button);
+			return btnname ? spn_makestring_nocopy(btnname) : spn_nilval;
+		}
+		case FIELD_STATE: return spn_makebool(event->button.state == SDL_PRESSED);
+		case FIELD_COUNT: return spn_makeint(event->button.clicks);
+		case FIELD_X:     return spn_makeint(event->button.x);
+		case FIELD_Y:     return spn_makeint(event->button.y);
+		default:          break;
+		}
+		break;
+	case SDL_MOUSEMOTION:
+		switch (field) {
+		case FIELD_X:           return spn_makeint(event->motion.x);
+		case FIELD_Y:           return spn_makeint(event->motion.y);
+		case FIELD_DX:          return spn_makeint(event->motion.xrel);
+		case FIELD_DY:          return spn_makeint(event->motion.yrel);
+		case FIELD_BUTTONS:     return hashmap_from_flags(mouse_button_flags, COUNT(mouse_button_flags), event->motion.state);
+		case FIELD_BUTTON_MASK: return spn_makeint(event->motion.state);
+		default:                break;
+		}
 		break;
-	}
 	case SDL_MOUSEWHEEL:
-		type = "mousewheel";
-
-		set_integer_property(hm, "x", event->wheel.x);
-		set_integer_property(hm, "y", event->wheel.y);
-
+		// relative changes in the motion of the wheel
+		switch (field) {
+		case FIELD_X: return spn_makeint(event->wheel.x);
+		case FIELD_Y: return spn_makeint(event->wheel.y);
+		default:      break;
+		}
 		break;
 	case SDL_FINGERDOWN:   // fallthru
 	case SDL_FINGERMOTION: // fallthru
 	case SDL_FINGERUP:
-		// first off, set type
-		switch (event->type) {
-		case SDL_FINGERDOWN:   type = "touchdown"; break;
-		case SDL_FINGERMOTION: type = "touchmove"; break;
-		case SDL_FINGERUP:     type = "touchup"; break;
-		}
-
-		// set geometrical properties
 		// Note that x, y, dx and dy are normalized
 		// to the [0...1] interval, unlike the similar properties
 		// of events of other types.
-		set_integer_property(hm, "finger", event->tfinger.fingerId);
-		set_float_property(hm, "x", event->tfinger.x);
-		set_float_property(hm, "y", event->tfinger.y);
-		set_float_property(hm, "dx", event->tfinger.dx);
-		set_float_property(hm, "dy", event->tfinger.dy);
-		set_float_property(hm, "pressure", event->tfinger.pressure);
-
+		switch (field) {
+		case FIELD_FINGER:   return spn_makeint(event->tfinger.fingerId);
+		case FIELD_X:        return spn_makefloat(event->tfinger.x);
+		case FIELD_Y:        return spn_makefloat(event->tfinger.y);
+		case FIELD_DX:       return spn_makefloat(event->tfinger.dx);
+		case FIELD_DY:       return spn_makefloat(event->tfinger.dy);
+		case FIELD_PRESSURE: return spn_makefloat(event->tfinger.pressure);
+		default:             break;
+		}
 		break;
 	case SDL_MULTIGESTURE:
-		type = "gesture";
-
-		// set geometrical properties
-		set_integer_property(hm, "fingerCount", event->mgesture.numFingers);
-
 		// again, x, y and distance are normalized to [0...1],
 		// and rotation is measured in radians.
-		set_float_property(hm, "x", event->mgesture.x);
-		set_float_property(hm, "y", event->mgesture.y);
-		set_float_property(hm, "rotation", event->mgesture.dTheta);
-		set_float_property(hm, "distance", event->mgesture.dDist);
-
-		break;
-	case SDL_QUIT:
-		type = "quit";
-		break;
-	case SDL_USEREVENT: {
-		type = "timer";
-		SpnValue timer = spn_makestrguserinfo(event->user.data1);
-		spn_hashmap_set_strkey(hm, "ID", &timer);
-		// do _not_ release 'timer' - we do not own it
+		switch (field) {
+		case FIELD_FINGER_COUNT: return spn_makeint(event->mgesture.numFingers);
+		case FIELD_X:            return spn_makefloat(event->mgesture.x);
+		case FIELD_Y:            return spn_makefloat(event->mgesture.y);
+		case FIELD_ROTATION:     return spn_makefloat(event->mgesture.dTheta);
+		case FIELD_DISTANCE:     return spn_makefloat(event->mgesture.dDist);
+		default:                 break;
+		}
 		break;
-	}
-	case SDL_WINDOWEVENT: {
-		type = "window";
-		set_integer_property(hm, "ID", event->window.windowID);
-
-		// set SDL_WindowEventID (SHOWN, HIDDEN, EXPOSED, etc.)
-		const char *name = get_window_event_name(event->window.event);
-		set_string_property_nocopy(hm, "name", name);
+	case SDL_USEREVENT:
+		if (data->timer && field == FIELD_ID) {
+			spn_object_retain(data->timer);
+			return spn_makestrguserinfo(data->timer);
+		}
 
-		// set event dependent data
-		set_integer_property(hm, "data1", event->window.data1);
-		set_integer_property(hm, "data2", event->window.data2);
+		if (event->user.code == SPN_SDL_USEREVENT_IMAGE_LOADED) {
+			switch (field) {
+			case FIELD_ID:
+				return spn_makeint(data->id);
+			case FIELD_FILENAME:
+				return data->text ? spn_makestring(data->text) : spn_nilval;
+			case FIELD_IMAGE:
+				// nil if the image couldn't be loaded
+				if (data->image == NULL) {
+					return spn_nilval;
+				}
+
+				spn_object_retain(data->image);
+				return spn_makestrguserinfo(data->image);
+			default:
+				break;
+			}
+		}
+		break;
+	case SDL_WINDOWEVENT:
+		switch (field) {
+		case FIELD_ID: return spn_makeint(event->window.windowID);
+		case FIELD_NAME: {
+			// SDL_WindowEventID (SHOWN, HIDDEN, EXPOSED, etc.)
+			const char *name = get_window_event_name(event->window.event);
+			return name ? spn_makestring_nocopy(name) : spn_nilval;
+		}
+		// event dependent data
+		case FIELD_DATA1: return spn_makeint(event->window.data1);
+		case FIELD_DATA2: return spn_makeint(event->window.data2);
+		default:          break;
+		}
 		break;
-	}
 	case SDL_DROPFILE:
-		type = "drop";
-		char *filename = event->drop.file;
-		set_string_property(hm, "value", filename);
-		SDL_free(filename);
+		if (field == FIELD_VALUE && data->text) {
+			return spn_makestring(data->text);
+		}
 		break;
 	default:
 		break;
 	}
 
-	// set type string and timestamp
-	SpnValue typestr = spn_makestring_nocopy(type);
-	spn_hashmap_set_strkey(hm, "type", &typestr);
-	spn_value_release(&typestr);
+	return spn_nilval;
+}
+
+// Converts an event to an SpnHashMap object
+static SpnValue event_to_hashmap(const EventData *data)
+{
+	SpnValue ret = spn_makehashmap();
+	SpnHashMap *hm = spn_hashmapvalue(&ret);
+
+	for (size_t i = 0; i < COUNT(hashmap_fields); i++) {
+		SpnValue val = event_field(data, hashmap_fields[i].field);
 
-	set_integer_property(hm, "timestamp", event->common.timestamp);
+		if (!spn_isnil(&val)) {
+			spn_hashmap_set_strkey(hm, hashmap_fields[i].name, &val);
+			spn_value_release(&val);
+		}
+	}
 
 	return ret;
 }
@@ -255,11 +510,482 @@ static SpnValue event_to_hashmap(SDL_Event *event)
 // Typically called in a loop.
 int spnlib_SDL_PollEvent(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
 {
-	SDL_Event event;
-	if (SDL_PollEvent(&event)) {
-		*ret = event_to_hashmap(&event);
+	EventData data;
+	if (poll_event(&data)) {
+		*ret = event_to_hashmap(&data);
+		event_data_free(&data);
 	}
 
 	// if there's no event to poll, return nil implicitly
 	return 0;
 }
+
+//
+// Event objects
+//
+
+// Wraps a polled event. Its properties are only converted to
+// Sparkling values when the corresponding method is called.
+typedef struct spn_SDL_Event {
+	SpnObject base;
+	EventData data;
+} spn_SDL_Event;
+
+static void spn_SDL_Event_dtor(void *obj)
+{
+	spn_SDL_Event *event = obj;
+	event_data_free(&event->data);
+}
+
+static const SpnClass spn_SDL_Event_class = {
+	sizeof(spn_SDL_Event),
+	SPN_SDL_CLASS_UID_EVENT,
+	NULL,
+	NULL,
+	NULL,
+	spn_SDL_Event_dtor
+};
+
+static spn_SDL_Event *event_from_hashmap(SpnHashMap *hm)
+{
+	SpnValue objv = spn_hashmap_get_strkey(hm, "event");
+
+	if (!spn_isstrguserinfo(&objv)) {
+		return NULL;
+	}
+
+	spn_SDL_Event *event = spn_objvalue(&objv);
+
+	if (!spn_object_member_of_class(event, &spn_SDL_Event_class)) {
+		return NULL;
+	}
+
+	return event;
+}
+
+#define CHECK_FOR_EVENT_HASHMAP(argnum)                                      \
+	CHECK_ARG_RETURN_ON_ERROR(argnum, hashmap);                              \
+	spn_SDL_Event *event = event_from_hashmap(HASHMAPARG(argnum));           \
+	if (event == NULL) {                                                     \
+		spn_ctx_runtime_error(ctx, "event object is invalid", NULL);         \
+		return -1;                                                           \
+	}
+
+// Wraps an event into an Event object, taking over its resources.
+// If 'object' isn't NULL, the native object is returned through it.
+static SpnValue event_to_object(const EventData *data, spn_SDL_Event **object)
+{
+	spn_SDL_Event *event = spn_object_new(&spn_SDL_Event_class);
+	event->data = *data;
+
+	if (object) {
+		*object = event;
+	}
+
+	// construct return value
+	SpnValue ret = spn_makehashmap();
+	SpnHashMap *hm = spn_hashmapvalue(&ret);
+
+	// set its prototype
+	SpnValue proto = spn_get_lib_prototype("Event");
+	spn_hashmap_set_strkey(hm, "super", &proto);
+
+	SpnValue eventval = spn_makestrguserinfo(event);
+	spn_hashmap_set_strkey(hm, "event", &eventval);
+	spn_value_release(&eventval);
+
+	return ret;
+}
+
+// Like SDL::PollEvent(), but returns an Event object instead of a
+// hashmap, or nil if there's no event to process
+int spnlib_SDL_NextEvent(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	EventData data;
+	if (poll_event(&data)) {
+		*ret = event_to_object(&data, NULL);
+	}
+
+	return 0;
+}
+
+//
+// Coalescing of motion events
+//
+
+// whether PollEvents() merges consecutive motion events
+static bool coalesce_motion = false;
+
+// Merges 'event' into 'into' if both are mouse motion, touch motion or
+// mouse wheel events of the same source. Positions are taken from the
+// later event and relative movements are summed. Mouse motion events
+// are only merged if the same buttons are held, so that changes of the
+// button state are never lost. Returns false if they can't be merged.
+static bool coalesce_event(SDL_Event *into, const SDL_Event *event)
+{
+	if (into->type != event->type) {
+		return false;
+	}
+
+	switch (event->type) {
+	case SDL_MOUSEMOTION:
+		if (into->motion.windowID != event->motion.windowID
+		 || into->motion.which != event->motion.which
+		 || into->motion.state != event->motion.state) {
+			return false;
+		}
+
+		into->motion.x = event->motion.x;
+		into->motion.y = event->motion.y;
+		into->motion.xrel += event->motion.xrel;
+		into->motion.yrel += event->motion.yrel;
+		break;
+	case SDL_FINGERMOTION:
+		if (into->tfinger.touchId != event->tfinger.touchId
+		 || into->tfinger.fingerId != event->tfinger.fingerId) {
+			return false;
+		}
+
+		into->tfinger.x = event->tfinger.x;
+		into->tfinger.y = event->tfinger.y;
+		into->tfinger.dx += event->tfinger.dx;
+		into->tfinger.dy += event->tfinger.dy;
+		into->tfinger.pressure = event->tfinger.pressure;
+		break;
+	case SDL_MOUSEWHEEL:
+		if (into->wheel.windowID != event->wheel.windowID
+		 || into->wheel.which != event->wheel.which
+		 || into->wheel.direction != event->wheel.direction) {
+			return false;
+		}
+
+		into->wheel.x += event->wheel.x;
+		into->wheel.y += event->wheel.y;
+		break;
+	default:
+		return false;
+	}
+
+	into->common.timestamp = event->common.timestamp;
+	return true;
+}
+
+static bool is_coalescable(const SDL_Event *event)
+{
+	return event->type == SDL_MOUSEMOTION
+	    || event->type == SDL_FINGERMOTION
+	    || event->type == SDL_MOUSEWHEEL;
+}
+
+// Motion events returned since the last event of another kind,
+// which later motion events may still be merged into
+typedef struct MotionRun {
+	spn_SDL_Event *events[16]; // owned by the returned array
+	int count;
+} MotionRun;
+
+// Returns true if 'event' was merged into an event of the run. Touch
+// motion events may skip those of other fingers, since fingers move
+// independently; any other event is only merged into the previous one.
+static bool motion_run_coalesce(MotionRun *run, const SDL_Event *event)
+{
+	for (int i = run->count - 1; i >= 0; i--) {
+		SDL_Event *prev = &run->events[i]->data.event;
+
+		if (coalesce_event(prev, event)) {
+			return true;
+		}
+
+		if (event->type != SDL_FINGERMOTION || prev->type != SDL_FINGERMOTION) {
+			break;
+		}
+	}
+
+	return false;
+}
+
+static void motion_run_add(MotionRun *run, spn_SDL_Event *event)
+{
+	if (!is_coalescable(&event->data.event)) {
+		run->count = 0;
+		return;
+	}
+
+	// forget the oldest event if the run is full
+	if (run->count == COUNT(run->events)) {
+		memmove(run->events, run->events + 1, (run->count - 1) * sizeof run->events[0]);
+		run->count--;
+	}
+
+	run->events[run->count++] = event;
+}
+
+// Parameters:
+// 0. Boolean, whether SDL::PollEvents() merges consecutive motion events
+int spnlib_SDL_SetEventCoalescing(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, bool);
+	coalesce_motion = BOOLARG(0);
+	return 0;
+}
+
+// Returns an array of Event objects: the pending events, in the order
+// they occurred, with a single native call. Events are taken off the
+// queue in batches using SDL_PeepEvents(); events of types that are not
+// requested are discarded without being converted, and the events after
+// the last one returned stay in the queue. Consecutive motion events are
+// merged if enabled by SDL::SetEventCoalescing(). Parameters:
+// 0. the maximal number of events to return
+// 1. (optional) array of the requested types, e. g. [ "keyboard", "quit" ];
+//    every type is requested if this is omitted or nil. "other" requests
+//    the events that have no type name of their own (e. g. text input).
+int spnlib_SDL_PollEvents(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, number);
+
+	double max_count = NUMARG(0);
+	Uint32 types = ~(Uint32)0;
+
+	if (argc > 1 && !spn_isnil(&argv[1])) {
+		CHECK_ARG_RETURN_ON_ERROR(1, array);
+
+		SpnArray *names = ARRAYARG(1);
+		size_t n = spn_array_count(names);
+		types = 0;
+
+		for (size_t i = 0; i < n; i++) {
+			SpnValue name = spn_array_get(names, i);
+			int type = TYPE_COUNT;
+
+			if (spn_isstring(&name)) {
+				const char *str = spn_stringvalue(&name)->cstr;
+
+				// their "type" property is empty, but they can be requested
+				if (strcmp(str, "other") == 0) {
+					type = TYPE_OTHER;
+				} else {
+					for (type = TYPE_OTHER + 1; type < TYPE_COUNT; type++) {
+						if (strcmp(event_type_names[type], str) == 0) {
+							break;
+						}
+					}
+				}
+			}
+
+			if (type == TYPE_COUNT) {
+				spn_ctx_runtime_error(ctx, "unknown event type", NULL);
+				return -2;
+			}
+
+			types |= (Uint32)1 << type;
+		}
+	}
+
+	*ret = spn_makearray();
+	SpnArray *events = spn_arrayvalue(ret);
+
+	size_t remaining = max_count > 0 ? max_count < SDL_MAX_SINT32 ? max_count : SDL_MAX_SINT32 : 0;
+	SDL_Event batch[64];
+	int n_events;
+	MotionRun run = { { NULL }, 0 };
+
+	SDL_PumpEvents();
+
+	while (remaining > 0) {
+		int size = remaining < COUNT(batch) ? remaining : COUNT(batch);
+		bool last;
+
+		if (types == ~(Uint32)0) {
+			// every event taken off the queue is returned
+			n_events = SDL_PeepEvents(batch, size, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+			last = n_events < size;
+		} else {
+			// Look ahead, so that events after the last one to be
+			// returned are left in the queue, then take the rest
+			// (including the ones to be discarded) off the queue.
+			int n_peeked = SDL_PeepEvents(batch, COUNT(batch), SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+			size_t n_requested = 0;
+
+			size = 0;
+			while (size < n_peeked && n_requested < remaining) {
+				if (types & (Uint32)1 << get_event_type(&batch[size++])) {
+					n_requested++;
+				}
+			}
+
+			n_events = size > 0 ? SDL_PeepEvents(batch, size, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) : 0;
+			last = n_peeked < (int)COUNT(batch);
+		}
+
+		for (int i = 0; i < n_events; i++) {
+			event_housekeeping(&batch[i]);
+
+			if ((types & (Uint32)1 << get_event_type(&batch[i])) == 0) {
+				discard_event(&batch[i]);
+				continue;
+			}
+
+			// merged events don't count towards 'maxCount'
+			if (coalesce_motion && motion_run_coalesce(&run, &batch[i])) {
+				continue;
+			}
+
+			EventData data;
+			event_data_init(&data, &batch[i]);
+
+			spn_SDL_Event *object;
+			SpnValue event = event_to_object(&data, &object);
+			spn_array_push(events, &event);
+			spn_value_release(&event);
+
+			motion_run_add(&run, object);
+			remaining--;
+		}
+
+		// the queue is empty (or an error occurred)
+		if (last || n_events <= 0) {
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/////////////////////////////////
+//       Event methods         //
+/////////////////////////////////
+
+static int event_get(SpnValue *ret, int argc, SpnValue *argv, void *ctx, EventField field)
+{
+	CHECK_FOR_EVENT_HASHMAP(0);
+	*ret = event_field(&event->data, field);
+	return 0;
+}
+
+// Every getter returns nil if events of the given type
+// don't have the corresponding property
+#define EVENT_GETTER(method, field)                                                         \
+	static int spnlib_SDL_Event_##method(SpnValue *ret, int argc, SpnValue *argv, void *ctx) \
+	{                                                                                        \
+		return event_get(ret, argc, argv, ctx, field);                                       \
+	}
+
+EVENT_GETTER(type,        FIELD_TYPE)
+EVENT_GETTER(timestamp,   FIELD_TIMESTAMP)
+EVENT_GETTER(value,       FIELD_VALUE)
+EVENT_GETTER(state,       FIELD_STATE)
+EVENT_GETTER(modifier,    FIELD_MODIFIER)
+EVENT_GETTER(modifiers,   FIELD_MODIFIERS)
+EVENT_GETTER(button,      FIELD_BUTTON)
+EVENT_GETTER(count,       FIELD_COUNT)
+EVENT_GETTER(x,           FIELD_X)
+EVENT_GETTER(y,           FIELD_Y)
+EVENT_GETTER(dx,          FIELD_DX)
+EVENT_GETTER(dy,          FIELD_DY)
+EVENT_GETTER(buttons,     FIELD_BUTTONS)
+EVENT_GETTER(buttonMask,  FIELD_BUTTON_MASK)
+EVENT_GETTER(finger,      FIELD_FINGER)
+EVENT_GETTER(pressure,    FIELD_PRESSURE)
+EVENT_GETTER(fingerCount, FIELD_FINGER_COUNT)
+EVENT_GETTER(rotation,    FIELD_ROTATION)
+EVENT_GETTER(distance,    FIELD_DISTANCE)
+EVENT_GETTER(ID,          FIELD_ID)
+EVENT_GETTER(name,        FIELD_NAME)
+EVENT_GETTER(data1,       FIELD_DATA1)
+EVENT_GETTER(data2,       FIELD_DATA2)
+EVENT_GETTER(filename,    FIELD_FILENAME)
+EVENT_GETTER(image,       FIELD_IMAGE)
+
+// Checks a single modifier key of a keyboard event, without building
+// the hashmap returned by modifier(). Parameters:
+// 0. the event object
+// 1. name of the modifier, e. g. "shift" or "lctrl"
+static int spnlib_SDL_Event_hasModifier(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_EVENT_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	const EventFlag *flag = find_flag(modifier_flags, COUNT(modifier_flags), STRARG(1));
+	if (flag == NULL) {
+		spn_ctx_runtime_error(ctx, "unknown modifier key", NULL);
+		return -2;
+	}
+
+	SpnValue mod = event_field(&event->data, FIELD_MODIFIERS);
+	*ret = spn_makebool(spn_isint(&mod) && (spn_intvalue(&mod) & flag->mask) != 0);
+
+	return 0;
+}
+
+// Checks whether a mouse button was held during a mousemove event.
+// Parameters:
+// 0. the event object
+// 1. name of the button: "left", "right", "middle", "X1" or "X2"
+static int spnlib_SDL_Event_hasButton(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_EVENT_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	const EventFlag *flag = find_flag(mouse_button_flags, COUNT(mouse_button_flags), STRARG(1));
+	if (flag == NULL) {
+		spn_ctx_runtime_error(ctx, "unknown mouse button", NULL);
+		return -2;
+	}
+
+	SpnValue buttons = event_field(&event->data, FIELD_BUTTON_MASK);
+	*ret = spn_makebool(spn_isint(&buttons) && (spn_intvalue(&buttons) & flag->mask) != 0);
+
+	return 0;
+}
+
+// Returns every property of the event in a hashmap,
+// just like the one returned by SDL::PollEvent()
+static int spnlib_SDL_Event_toHashMap(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_EVENT_HASHMAP(0);
+	*ret = event_to_hashmap(&event->data);
+	return 0;
+}
+
+/////////////////////////////////
+//   Event methods creation    //
+/////////////////////////////////
+void spnlib_SDL_methods_for_Event(SpnHashMap *event)
+{
+	static const SpnExtFunc methods[] = {
+		{ "type",        spnlib_SDL_Event_type        },
+		{ "timestamp",   spnlib_SDL_Event_timestamp   },
+		{ "value",       spnlib_SDL_Event_value       },
+		{ "state",       spnlib_SDL_Event_state       },
+		{ "modifier",    spnlib_SDL_Event_modifier    },
+		{ "modifiers",   spnlib_SDL_Event_modifiers   },
+		{ "hasModifier", spnlib_SDL_Event_hasModifier },
+		{ "button",      spnlib_SDL_Event_button      },
+		{ "count",       spnlib_SDL_Event_count       },
+		{ "x",           spnlib_SDL_Event_x           },
+		{ "y",           spnlib_SDL_Event_y           },
+		{ "dx",          spnlib_SDL_Event_dx          },
+		{ "dy",          spnlib_SDL_Event_dy          },
+		{ "buttons",     spnlib_SDL_Event_buttons     },
+		{ "buttonMask",  spnlib_SDL_Event_buttonMask  },
+		{ "hasButton",   spnlib_SDL_Event_hasButton   },
+		{ "finger",      spnlib_SDL_Event_finger      },
+		{ "pressure",    spnlib_SDL_Event_pressure    },
+		{ "fingerCount", spnlib_SDL_Event_fingerCount },
+		{ "rotation",    spnlib_SDL_Event_rotation    },
+		{ "distance",    spnlib_SDL_Event_distance    },
+		{ "ID",          spnlib_SDL_Event_ID          },
+		{ "name",        spnlib_SDL_Event_name        },
+		{ "data1",       spnlib_SDL_Event_data1       },
+		{ "data2",       spnlib_SDL_Event_data2       },
+		{ "filename",    spnlib_SDL_Event_filename    },
+		{ "image",       spnlib_SDL_Event_image       },
+		{ "toHashMap",   spnlib_SDL_Event_toHashMap   }
+	};
+
+	for (size_t i = 0; i < COUNT(methods); i++) {
+		SpnValue fnval = spn_makenativefunc(methods[i].name, methods[i].fn);
+		spn_hashmap_set_strkey(event, methods[i].name, &fnval);
+		spn_value_release(&fnval);
+	}
+}
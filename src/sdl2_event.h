@@ -16,6 +16,19 @@
 
 #include <SDL2/SDL.h>
 
+// Codes of the SDL_USEREVENTs pushed by the library
+enum {
+	SPN_SDL_USEREVENT_TIMER           = 0, // data1: the timer object
+	SPN_SDL_USEREVENT_IMAGE_LOADED    = 1, // data1: an SPN_SDL_ImageLoad
+	SPN_SDL_USEREVENT_REPLAY_FINISHED = 2  // no data
+};
+
 SPN_API int spnlib_SDL_PollEvent(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+SPN_API int spnlib_SDL_NextEvent(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+SPN_API int spnlib_SDL_PollEvents(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+SPN_API int spnlib_SDL_SetEventCoalescing(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+
+// In order to bridge data between sdl2_sparkling.c and this file
+void spnlib_SDL_methods_for_Event(SpnHashMap *event);
 
 #endif // SPNLIB_SDL2_EVENT_H
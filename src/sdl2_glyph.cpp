@@ -0,0 +1,720 @@
+//
+// sdl2_glyph.cpp
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#include "sdl2_glyph.h"
+#include "sdl2_text_layout.h"
+#include "sdl2_texture_cache.h"
+
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+
+Uint32 spnlib_sdl2_utf8_next(const char **text)
+{
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(*text);
+	const Uint32 replacement = 0xfffd;
+
+	if (p[0] == 0) {
+		return 0;
+	}
+
+	// ASCII fast path
+	if (p[0] < 0x80) {
+		*text += 1;
+		return p[0];
+	}
+
+	// the lead byte determines the length of the sequence
+	// and the smallest code point it may encode (so that
+	// overlong encodings are rejected)
+	int length;
+	Uint32 cp, min;
+
+	if (p[0] >= 0xc2 && p[0] <= 0xdf) {
+		length = 2;
+		cp = p[0] & 0x1f;
+		min = 0x80;
+	} else if (p[0] >= 0xe0 && p[0] <= 0xef) {
+		length = 3;
+		cp = p[0] & 0x0f;
+		min = 0x800;
+	} else if (p[0] >= 0xf0 && p[0] <= 0xf4) {
+		length = 4;
+		cp = p[0] & 0x07;
+		min = 0x10000;
+	} else {
+		*text += 1;
+		return replacement;
+	}
+
+	for (int i = 1; i < length; i++) {
+		// also stops at the terminating NUL byte
+		if ((p[i] & 0xc0) != 0x80) {
+			*text += 1;
+			return replacement;
+		}
+
+		cp = cp << 6 | (p[i] & 0x3f);
+	}
+
+	// overlong encodings, surrogates and out-of-range code points
+	if (cp < min || (cp >= 0xd800 && cp <= 0xdfff) || cp > 0x10ffff) {
+		*text += 1;
+		return replacement;
+	}
+
+	*text += length;
+	return cp;
+}
+
+// A glyph rasterized into an atlas page. The pixels are the same as
+// those TTF_RenderGlyph_Blended() produces: a cell of the height of
+// the font, with the glyph at its baseline.
+struct Glyph {
+	int page; // index of the atlas page, -1 if the glyph has no pixels
+	SDL_Rect rect; // location of the glyph within the page
+	int xoffset; // of the left edge of the cell relative to the pen position
+};
+
+// SDL_ttf only handles the Basic Multilingual Plane
+static Uint16 to_bmp(Uint32 cp)
+{
+	return cp > 0xffff ? 0xfffd : cp;
+}
+
+// Advances and kerning of the glyphs of a TrueType font.
+// These don't depend on the renderer.
+class FontMetrics : public TextMetrics {
+	TTF_Font *font;
+	bool kerning;
+
+	std::unordered_map<Uint16, int> advances;
+	std::unordered_map<Uint32, int> kernings; // by (left << 16 | right)
+
+public:
+	FontMetrics(TTF_Font *fnt) :
+		font(fnt),
+		kerning(TTF_GetFontKerning(fnt) != 0)
+	{}
+
+	int advance(Uint32 cp) override
+	{
+		Uint16 ch = to_bmp(cp);
+		auto it = advances.find(ch);
+
+		if (it == advances.end()) {
+			int adv = 0;
+			TTF_GlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &adv);
+			it = advances.emplace(ch, adv).first;
+		}
+
+		return it->second;
+	}
+
+	int kern(Uint32 left, Uint32 right) override
+	{
+		if (!kerning || left == 0) {
+			return 0;
+		}
+
+		Uint16 l = to_bmp(left), r = to_bmp(right);
+		Uint32 pair = Uint32(l) << 16 | r;
+		auto it = kernings.find(pair);
+
+		if (it == kernings.end()) {
+			it = kernings.emplace(pair, TTF_GetFontKerningSizeGlyphs(font, l, r)).first;
+		}
+
+		return it->second;
+	}
+
+	int line_skip() override
+	{
+		return TTF_FontLineSkip(font);
+	}
+
+	int height() override
+	{
+		return TTF_FontHeight(font);
+	}
+};
+
+int TextMetrics::width(const char *text)
+{
+	int pen = 0, widest = 0;
+	Uint32 prev = 0;
+
+	while (Uint32 cp = spnlib_sdl2_utf8_next(&text)) {
+		if (cp == '\n') {
+			widest = std::max(widest, pen);
+			pen = 0;
+			prev = 0;
+			continue;
+		}
+
+		pen += kern(prev, cp) + advance(cp);
+		prev = cp;
+	}
+
+	return std::max(widest, pen);
+}
+
+const TextLayout &TextMetrics::layout(const char *text, int wrap_width)
+{
+	LayoutKey key = { text, wrap_width };
+	auto it = layout_index.find(key);
+
+	if (it != layout_index.end()) {
+		layouts.splice(layouts.begin(), layouts, it->second);
+		return it->second->second;
+	}
+
+	if (layouts.size() >= max_layouts) {
+		layout_index.erase(layouts.back().first);
+		layouts.pop_back();
+	}
+
+	layouts.emplace_front(key, compute_layout(text, wrap_width));
+	layout_index[key] = layouts.begin();
+
+	return layouts.front().second;
+}
+
+SPN_SDL_TextBoxSize TextMetrics::box_size(const char *text, int wrap_width, int line_height)
+{
+	const TextLayout &lines = layout(text, wrap_width);
+	int n = lines.lines.size();
+
+	SPN_SDL_TextBoxSize size;
+	size.width = lines.width;
+	size.height = (n - 1) * (line_height > 0 ? line_height : line_skip()) + height();
+	size.lines = n;
+
+	return size;
+}
+
+// Greedy line breaking: lines are broken at the last space that
+// fits; words longer than a line are broken between characters.
+// Spaces at the end of wrapped lines are not drawn or measured.
+TextLayout TextMetrics::compute_layout(const char *text, int wrap_width)
+{
+	TextLayout layout;
+	layout.width = 0;
+
+	const char *start = text;
+	std::size_t line_begin = 0;
+	int pen = 0;
+	Uint32 prev = 0;
+
+	// the last opportunity for breaking the current line:
+	// the line would end before a run of spaces, and the
+	// next one would start after it
+	bool can_break = false;
+	bool in_spaces = false;
+	std::size_t break_end = 0, break_next = 0;
+	int break_width = 0, next_pen = 0;
+
+	auto end_line = [&](std::size_t end, int width) {
+		layout.lines.push_back({ line_begin, end, width });
+		layout.width = std::max(layout.width, width);
+	};
+
+	while (true) {
+		std::size_t pos = text - start;
+		Uint32 cp = spnlib_sdl2_utf8_next(&text);
+
+		if (cp == 0 || cp == '\n') {
+			end_line(pos, in_spaces ? break_width : pen);
+
+			if (cp == 0) {
+				break;
+			}
+
+			line_begin = text - start;
+			pen = 0;
+			prev = 0;
+			can_break = in_spaces = false;
+			continue;
+		}
+
+		int extent = kern(prev, cp) + advance(cp);
+
+		if (cp == ' ') {
+			if (!in_spaces) {
+				break_end = pos;
+				break_width = pen;
+				in_spaces = true;
+			}
+
+			pen += extent;
+			prev = cp;
+
+			// spaces never cause a line break; leading
+			// spaces are no opportunity for breaking either
+			can_break = break_end > line_begin;
+			break_next = text - start;
+			next_pen = pen;
+			continue;
+		}
+
+		in_spaces = false;
+
+		if (wrap_width > 0 && pen + extent > wrap_width && can_break) {
+			end_line(break_end, break_width);
+			line_begin = break_next;
+			pen -= next_pen;
+			can_break = false;
+		}
+
+		// the rest of the word may still be too long
+		if (wrap_width > 0 && pen + extent > wrap_width && pos > line_begin) {
+			end_line(pos, pen);
+			line_begin = pos;
+			pen = 0;
+			extent = advance(cp);
+		}
+
+		pen += extent;
+		prev = cp;
+	}
+
+	return layout;
+}
+
+// Glyphs are packed into pages on shelves: horizontal strips of
+// the height of the first glyph placed on them. A glyph goes on
+// the lowest shelf it fits on, or on a new shelf below the others.
+struct Shelf {
+	int y, height;
+	int x; // free space starts here
+};
+
+class GlyphAtlas {
+	SDL_Renderer *renderer;
+	Uint32 format;
+	TTF_Font *font;
+	FontMetrics &metrics;
+	int page_size;
+
+	std::vector<SDL_Texture *> pages;
+	std::vector<Shelf> shelves; // of the last page; older ones are full
+	std::unordered_map<Uint32, Glyph> glyphs;
+
+	// space between glyphs, so that they don't bleed into each other
+	static const int padding = 1;
+	static const int max_page_size = 1024;
+
+	bool add_page()
+	{
+		SDL_Texture *page = SDL_CreateTexture(
+			renderer,
+			format,
+			SDL_TEXTUREACCESS_STATIC,
+			page_size,
+			page_size
+		);
+
+		if (page == NULL) {
+			return false;
+		}
+
+		SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+		pages.push_back(page);
+		shelves.clear();
+
+		return true;
+	}
+
+	// Finds room for a w * h rectangle on the current page.
+	// Returns false if it doesn't fit.
+	bool allocate_on_page(int w, int h, SDL_Rect *rect)
+	{
+		Shelf *best = NULL;
+
+		for (Shelf &shelf : shelves) {
+			if (shelf.height >= h && page_size - shelf.x >= w) {
+				// prefer the tightest shelf, so that
+				// tall ones aren't filled with small glyphs
+				if (best == NULL || shelf.height < best->height) {
+					best = &shelf;
+				}
+			}
+		}
+
+		if (best == NULL) {
+			int y = shelves.empty() ? 0 : shelves.back().y + shelves.back().height;
+
+			if (page_size - y < h) {
+				return false;
+			}
+
+			shelves.push_back({ y, h, 0 });
+			best = &shelves.back();
+		}
+
+		*rect = { best->x, best->y, w, h };
+		best->x += w;
+
+		return true;
+	}
+
+	bool allocate(int w, int h, SDL_Rect *rect)
+	{
+		w += padding;
+		h += padding;
+
+		if (w > page_size || h > page_size) {
+			return false;
+		}
+
+		if (pages.empty() || !allocate_on_page(w, h, rect)) {
+			if (!add_page() || !allocate_on_page(w, h, rect)) {
+				return false;
+			}
+		}
+
+		rect->w -= padding;
+		rect->h -= padding;
+
+		return true;
+	}
+
+	Glyph rasterize(Uint16 ch)
+	{
+		Glyph glyph = { -1, { 0, 0, 0, 0 }, 0 };
+
+		int minx, maxx, miny, maxy, advance;
+		if (TTF_GlyphMetrics(font, ch, &minx, &maxx, &miny, &maxy, &advance) < 0) {
+			return glyph;
+		}
+
+		// TTF_RenderGlyph_Blended() shifts glyphs with a negative
+		// left bearing to the right, so that they are not clipped
+		glyph.xoffset = std::min(minx, 0);
+
+		// rendered in white so that any color can be applied by modulation
+		SDL_Surface *surface = TTF_RenderGlyph_Blended(font, ch, SDL_Color { 255, 255, 255, 255 });
+		if (surface == NULL) {
+			return glyph;
+		}
+
+		if (surface->format->format != format) {
+			SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+			SDL_FreeSurface(surface);
+			surface = converted;
+
+			if (surface == NULL) {
+				return glyph;
+			}
+		}
+
+		if (allocate(surface->w, surface->h, &glyph.rect)) {
+			glyph.page = int(pages.size()) - 1;
+
+			SDL_LockSurface(surface);
+			SDL_UpdateTexture(pages.back(), &glyph.rect, surface->pixels, surface->pitch);
+			SDL_UnlockSurface(surface);
+		}
+
+		SDL_FreeSurface(surface);
+		return glyph;
+	}
+
+public:
+	GlyphAtlas(SDL_Renderer *rend, Uint32 fmt, TTF_Font *fnt, FontMetrics &mtx) :
+		renderer(rend),
+		format(fmt),
+		font(fnt),
+		metrics(mtx),
+		page_size(max_page_size)
+	{
+		SDL_RendererInfo info;
+
+		if (SDL_GetRendererInfo(renderer, &info) == 0) {
+			if (info.max_texture_width > 0) {
+				page_size = std::min(page_size, info.max_texture_width);
+			}
+
+			if (info.max_texture_height > 0) {
+				page_size = std::min(page_size, info.max_texture_height);
+			}
+		}
+	}
+
+	GlyphAtlas(const GlyphAtlas &) = delete;
+	GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+
+	~GlyphAtlas()
+	{
+		for (SDL_Texture *page : pages) {
+			SDL_DestroyTexture(page);
+		}
+	}
+
+	const Glyph &glyph(Uint16 ch)
+	{
+		auto it = glyphs.find(ch);
+
+		if (it == glyphs.end()) {
+			it = glyphs.emplace(ch, rasterize(ch)).first;
+		}
+
+		return it->second;
+	}
+
+	// Draws the characters of 'text' up to 'end' (or up to the
+	// first newline or the terminating NUL byte, whichever comes
+	// first) on a single line. Returns where drawing stopped.
+	// 'tinted_page' is the page that 'color' was last applied to.
+	const char *draw_line(
+		int x,
+		int y,
+		const char *text,
+		const char *end,
+		SDL_Color color,
+		int &tinted_page
+	)
+	{
+		int pen = x;
+		Uint32 prev = 0;
+
+		while (text < end) {
+			const char *next = text;
+			Uint32 cp = spnlib_sdl2_utf8_next(&next);
+
+			if (cp == 0 || cp == '\n') {
+				break;
+			}
+
+			text = next;
+			pen += metrics.kern(prev, cp);
+
+			const Glyph &g = glyph(to_bmp(cp));
+
+			if (g.page >= 0) {
+				SDL_Texture *page = pages[g.page];
+
+				// consecutive glyphs are usually on the same page
+				if (g.page != tinted_page) {
+					SDL_SetTextureColorMod(page, color.r, color.g, color.b);
+					SDL_SetTextureAlphaMod(page, color.a);
+					tinted_page = g.page;
+				}
+
+				SDL_Rect dst = { pen + g.xoffset, y, g.rect.w, g.rect.h };
+				SDL_RenderCopy(renderer, page, &g.rect, &dst);
+			}
+
+			pen += metrics.advance(cp);
+			prev = cp;
+		}
+
+		return text;
+	}
+
+	// Draws a line of fixed-width cells. Tinting is
+	// only changed when the color or the page does.
+	void draw_cells(int x, int y, int cell_width, const SPN_SDL_Cell *cells, int count)
+	{
+		int tinted_page = -1;
+		Uint32 tint = 0;
+
+		for (int i = 0; i < count; i++, x += cell_width) {
+			Uint32 cp = cells[i].cp;
+
+			if (cp == 0 || cp == ' ') {
+				continue;
+			}
+
+			const Glyph &g = glyph(to_bmp(cp));
+
+			if (g.page < 0) {
+				continue;
+			}
+
+			SDL_Texture *page = pages[g.page];
+
+			if (g.page != tinted_page || cells[i].color != tint) {
+				tint = cells[i].color;
+				SDL_SetTextureColorMod(page, tint >> 24, tint >> 16 & 0xff, tint >> 8 & 0xff);
+				SDL_SetTextureAlphaMod(page, tint & 0xff);
+				tinted_page = g.page;
+			}
+
+			SDL_Rect dst = { x + g.xoffset, y, g.rect.w, g.rect.h };
+			SDL_RenderCopy(renderer, page, &g.rect, &dst);
+		}
+	}
+
+	void draw(int x, int y, const char *text, SDL_Color color)
+	{
+		int tinted_page = -1;
+
+		draw_text_lines(x, y, text, metrics.line_skip(), [&](int lx, int ly, const char *begin, const char *end) {
+			return draw_line(lx, ly, begin, end, color, tinted_page);
+		});
+	}
+
+	void draw_box(
+		int x,
+		int y,
+		const char *text,
+		int wrap_width,
+		SPN_SDL_TextAlign align,
+		int line_height,
+		SDL_Color color
+	)
+	{
+		int tinted_page = -1;
+
+		draw_text_box(metrics, x, y, text, wrap_width, align, line_height, [&](int lx, int ly, const char *begin, const char *end) {
+			return draw_line(lx, ly, begin, end, color, tinted_page);
+		});
+	}
+};
+
+// The glyphs of a font depend on its style, and
+// textures belong to the renderer that created them
+struct AtlasKey {
+	SDL_Renderer *renderer;
+	TTF_Font *font;
+	int style;
+
+	bool operator==(const AtlasKey &that) const {
+		return renderer == that.renderer && font == that.font && style == that.style;
+	}
+};
+
+struct AtlasKeyHash {
+	std::size_t operator()(const AtlasKey &key) const {
+		std::size_t seed = std::hash<SDL_Renderer *>()(key.renderer);
+		texture_cache_hash_combine(seed, std::hash<TTF_Font *>()(key.font));
+		texture_cache_hash_combine(seed, std::hash<int>()(key.style));
+		return seed;
+	}
+};
+
+struct MetricsKey {
+	TTF_Font *font;
+	int style;
+
+	bool operator==(const MetricsKey &that) const {
+		return font == that.font && style == that.style;
+	}
+};
+
+struct MetricsKeyHash {
+	std::size_t operator()(const MetricsKey &key) const {
+		std::size_t seed = std::hash<TTF_Font *>()(key.font);
+		texture_cache_hash_combine(seed, std::hash<int>()(key.style));
+		return seed;
+	}
+};
+
+// Declared before the atlases, which refer to the metrics,
+// so that the atlases are destroyed first
+static std::unordered_map<MetricsKey, std::unique_ptr<FontMetrics>, MetricsKeyHash> font_metrics;
+static std::unordered_map<AtlasKey, std::unique_ptr<GlyphAtlas>, AtlasKeyHash> atlases;
+
+static FontMetrics &get_metrics(TTF_Font *font)
+{
+	auto &metrics = font_metrics[{ font, TTF_GetFontStyle(font) }];
+
+	if (metrics == nullptr) {
+		metrics.reset(new FontMetrics(font));
+	}
+
+	return *metrics;
+}
+
+static GlyphAtlas &get_atlas(SDL_Renderer *renderer, Uint32 format, TTF_Font *font)
+{
+	auto &atlas = atlases[{ renderer, font, TTF_GetFontStyle(font) }];
+
+	if (atlas == nullptr) {
+		atlas.reset(new GlyphAtlas(renderer, format, font, get_metrics(font)));
+	}
+
+	return *atlas;
+}
+
+void spnlib_sdl2_draw_text(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	TTF_Font *font,
+	int x,
+	int y,
+	const char *text,
+	SDL_Color color
+)
+{
+	get_atlas(renderer, format, font).draw(x, y, text, color);
+}
+
+int spnlib_sdl2_text_width(TTF_Font *font, const char *text)
+{
+	return get_metrics(font).width(text);
+}
+
+SPN_SDL_TextBoxSize spnlib_sdl2_text_box_size(
+	TTF_Font *font,
+	const char *text,
+	int wrap_width,
+	int line_height
+)
+{
+	return get_metrics(font).box_size(text, wrap_width, line_height);
+}
+
+void spnlib_sdl2_draw_text_box(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	TTF_Font *font,
+	int x,
+	int y,
+	const char *text,
+	int wrap_width,
+	SPN_SDL_TextAlign align,
+	int line_height,
+	SDL_Color color
+)
+{
+	get_atlas(renderer, format, font).draw_box(x, y, text, wrap_width, align, line_height, color);
+}
+
+void spnlib_sdl2_draw_cells(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	TTF_Font *font,
+	int x,
+	int y,
+	int cell_width,
+	const SPN_SDL_Cell *cells,
+	int count
+)
+{
+	get_atlas(renderer, format, font).draw_cells(x, y, cell_width, cells, count);
+}
+
+int spnlib_sdl2_glyph_advance(TTF_Font *font, Uint32 cp)
+{
+	return get_metrics(font).advance(cp);
+}
+
+void spnlib_sdl2_glyph_release_renderer(SDL_Renderer *renderer)
+{
+	for (auto it = atlases.begin(); it != atlases.end(); ) {
+		if (it->first.renderer == renderer) {
+			it = atlases.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
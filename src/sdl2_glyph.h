@@ -0,0 +1,108 @@
+//
+// sdl2_glyph.h
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#ifndef SPNLIB_SDL2_GLYPH_H
+#define SPNLIB_SDL2_GLYPH_H
+
+#include <spn/api.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+// Decodes the UTF-8 sequence at '*text' and advances '*text' past it.
+// Returns 0 (without advancing) at the terminating NUL byte, and
+// U+FFFD REPLACEMENT CHARACTER for each byte of malformed sequences.
+SPN_API Uint32 spnlib_sdl2_utf8_next(const char **text);
+
+// Draws 'text' at (x, y) in 'color', using the current style of 'font'.
+// Each glyph is rasterized only once per (renderer, font, style), in white,
+// into an atlas texture of 'format'; strings are then drawn as textured
+// quads out of the atlas, tinted using color modulation, and kerned.
+// Newline characters start a new line.
+SPN_API void spnlib_sdl2_draw_text(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	TTF_Font *font,
+	int x,
+	int y,
+	const char *text,
+	SDL_Color color
+);
+
+// Width of the widest line of 'text' as drawn by spnlib_sdl2_draw_text().
+// Glyph advances and kerning are cached per (font, style), so measuring
+// many strings is cheap.
+SPN_API int spnlib_sdl2_text_width(TTF_Font *font, const char *text);
+
+typedef enum SPN_SDL_TextAlign {
+	SPN_SDL_ALIGN_LEFT,
+	SPN_SDL_ALIGN_CENTER,
+	SPN_SDL_ALIGN_RIGHT
+} SPN_SDL_TextAlign;
+
+typedef struct SPN_SDL_TextBoxSize {
+	int width; // of the widest line
+	int height;
+	int lines;
+} SPN_SDL_TextBoxSize;
+
+// Size of 'text' laid out by spnlib_sdl2_draw_text_box()
+SPN_API SPN_SDL_TextBoxSize spnlib_sdl2_text_box_size(
+	TTF_Font *font,
+	const char *text,
+	int wrap_width,
+	int line_height
+);
+
+// Draws 'text' broken into lines at most 'wrap_width' pixels wide (at
+// spaces, or between characters if a word doesn't fit on a line), and
+// at newline characters. 'wrap_width' <= 0 means no wrapping. Lines are
+// aligned within 'wrap_width' (or within the widest line, if there's no
+// wrapping), 'line_height' pixels apart (<= 0 means the default line
+// skip of the font). The most recently used layouts are cached, so
+// redrawing the same text with the same wrap width is cheap.
+SPN_API void spnlib_sdl2_draw_text_box(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	TTF_Font *font,
+	int x,
+	int y,
+	const char *text,
+	int wrap_width,
+	SPN_SDL_TextAlign align,
+	int line_height,
+	SDL_Color color
+);
+
+// A character cell of a text grid: a code point (0 for an empty cell)
+// and its color, packed as 0xRRGGBBAA
+typedef struct SPN_SDL_Cell {
+	Uint32 cp;
+	Uint32 color;
+} SPN_SDL_Cell;
+
+// Draws 'count' cells on a single line starting at (x, y), each one
+// 'cell_width' pixels wide, using the same glyph atlas as
+// spnlib_sdl2_draw_text(). Glyphs are not kerned.
+SPN_API void spnlib_sdl2_draw_cells(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	TTF_Font *font,
+	int x,
+	int y,
+	int cell_width,
+	const SPN_SDL_Cell *cells,
+	int count
+);
+
+// Horizontal advance of the glyph of 'cp'
+SPN_API int spnlib_sdl2_glyph_advance(TTF_Font *font, Uint32 cp);
+
+// Must be called before 'renderer' is destroyed
+SPN_API void spnlib_sdl2_glyph_release_renderer(SDL_Renderer *renderer);
+
+#endif // SPNLIB_SDL2_GLYPH_H
@@ -10,20 +10,19 @@
 
 
 #include "sdl2_gradient.h"
+#include "sdl2_sparkling.h"
+#include "sdl2_texture_cache.h"
 #include <SDL2/SDL2_gfxPrimitives.h>
 
 #include <spn/hashmap.h>
 
 #include <algorithm>
 #include <vector>
+#include <unordered_map>
+#include <functional>
 #include <cstdlib>
 #include <cmath>
 
-#define RMASK 0xff000000
-#define GMASK 0x00ff0000
-#define BMASK 0x0000ff00
-#define AMASK 0x000000ff
-
 #define RGBA32(rv, gv, bv, av) \
 	((Uint32(rv) << 24) | (Uint32(gv) << 16) | (Uint32(bv) << 8) | (Uint32(av) << 0))
 
@@ -102,7 +101,73 @@ bool spnlib_sdl2_array_to_colorstop(
 	return true;
 }
 
-static Uint32 interpolate_color_rgba32(
+// Describes where the 8-bit color components
+// are stored within a packed 32-bit pixel
+struct PixelLayout {
+	int rshift, gshift, bshift, ashift;
+
+	Uint32 pack(SDL_Color c) const {
+		return (Uint32(c.r) << rshift)
+		     | (Uint32(c.g) << gshift)
+		     | (Uint32(c.b) << bshift)
+		     | (Uint32(c.a) << ashift);
+	}
+};
+
+// Returns the position of an 8-bit-wide mask within a 32-bit word,
+// or -1 if 'mask' does not consist of 8 contiguous aligned bits
+static int byte_mask_shift(Uint32 mask)
+{
+	for (int shift = 0; shift < 32; shift += 8) {
+		if (mask == Uint32(0xff) << shift) {
+			return shift;
+		}
+	}
+
+	return -1;
+}
+
+// Computes the layout of a 32-bit pixel format with
+// 8-bit color components (e. g. ARGB8888 or RGB888).
+// Returns false if 'format' is not such a format.
+static bool layout_for_format(Uint32 format, PixelLayout *layout)
+{
+	int bpp;
+	Uint32 rmask, gmask, bmask, amask;
+
+	if (!SDL_PixelFormatEnumToMasks(format, &bpp, &rmask, &gmask, &bmask, &amask) || bpp != 32) {
+		return false;
+	}
+
+	layout->rshift = byte_mask_shift(rmask);
+	layout->gshift = byte_mask_shift(gmask);
+	layout->bshift = byte_mask_shift(bmask);
+
+	if (layout->rshift < 0 || layout->gshift < 0 || layout->bshift < 0) {
+		return false;
+	}
+
+	// formats without an alpha channel (e. g. RGB888) have one unused
+	// byte; write alpha there, it is ignored anyway.
+	layout->ashift = amask ? byte_mask_shift(amask) : 48 - layout->rshift - layout->gshift - layout->bshift;
+
+	return layout->ashift >= 0;
+}
+
+// Returns the format gradients are generated in for a renderer that
+// prefers 'format': the format itself if pixels can be computed in it
+// directly, or ARGB8888 (which SDL converts from if needed) otherwise.
+static Uint32 gradient_format(Uint32 format, PixelLayout *layout)
+{
+	if (!layout_for_format(format, layout)) {
+		format = SDL_PIXELFORMAT_ARGB8888;
+		layout_for_format(format, layout);
+	}
+
+	return format;
+}
+
+static SDL_Color interpolate_color(
 	const SPN_SDL_ColorStop color_stops[],
 	unsigned n,
 	double p
@@ -123,14 +188,12 @@ static Uint32 interpolate_color_rgba32(
 	if (it == color_stops) {
 		// degenerate case: first color-stop point is
 		// already >= p (probably p is 0 or negative)
-		auto c = color_stops[0].color;
-		return RGBA32(c.r, c.g, c.b, c.a);
+		return color_stops[0].color;
 	} else if (it == color_stops + n) {
 		// degenerate case: p > maximal color-stop point
 		// (there's no higher color stop point to interpolate
 		// towards, p is probably 1 or more)
-		auto c = color_stops[n - 1].color;
-		return RGBA32(c.r, c.g, c.b, c.a);
+		return color_stops[n - 1].color;
 	}
 
 	// non-degenerate case: p falls somewhere between
@@ -151,67 +214,136 @@ static Uint32 interpolate_color_rgba32(
 	Uint8 b = std::sqrt(c0.b * c0.b * (1 - q) + c1.b * c1.b * q);
 	Uint8 a = std::sqrt(c0.a * c0.a * (1 - q) + c1.a * c1.a * q);
 
-	return RGBA32(r, g, b, a);
+	return { r, g, b, a };
 }
 
+// Color sources map a color-stop progress value to a packed pixel.
+// This one interpolates between the color stops for every pixel...
+struct StopsColorSource {
+	const SPN_SDL_ColorStop *color_stops;
+	unsigned n;
+	PixelLayout layout;
+
+	Uint32 operator()(double p) const {
+		return layout.pack(interpolate_color(color_stops, n, p));
+	}
+};
+
+// ...whereas this one looks colors up in the table of a Gradient
+// object, packed in advance according to the pixel layout.
+class LutColorSource {
+	Uint32 lut[SPN_SDL_GRADIENT_LUT_SIZE];
+
+public:
+	LutColorSource(const spn_SDL_Gradient *gradient, const PixelLayout &layout)
+	{
+		for (int i = 0; i < SPN_SDL_GRADIENT_LUT_SIZE; i++) {
+			lut[i] = layout.pack(gradient->lut[i]);
+		}
+	}
+
+	Uint32 operator()(double p) const {
+		// negated comparison, so that NaN maps to the first color
+		if (!(p > 0)) {
+			return lut[0];
+		}
+
+		if (p >= 1) {
+			return lut[SPN_SDL_GRADIENT_LUT_SIZE - 1];
+		}
+
+		return lut[int(p * (SPN_SDL_GRADIENT_LUT_SIZE - 1) + 0.5)];
+	}
+};
+
 static SDL_Texture *renderPixelBuffer(
 	SDL_Renderer *renderer,
-	std::vector<Uint32> &buf, // must be non-const, blame SDL_CreateRGBSurfaceFrom
+	const std::vector<Uint32> &buf,
 	int width,
-	int height
+	int height,
+	Uint32 format
 )
 {
-	SDL_Surface *surface = SDL_CreateRGBSurfaceFrom(
-		buf.data(),
+	// the pixels are already in the format of the texture,
+	// so uploading them is a plain copy
+	SDL_Texture *texture = SDL_CreateTexture(
+		renderer,
+		format,
+		SDL_TEXTUREACCESS_STATIC,
 		width,
-		height,
-		32,
-		width * sizeof buf[0],
-		RMASK,
-		GMASK,
-		BMASK,
-		AMASK
+		height
 	);
 
-	SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
-	SDL_FreeSurface(surface);
+	if (texture == NULL) {
+		return NULL;
+	}
+
+	SDL_UpdateTexture(texture, NULL, buf.data(), width * sizeof buf[0]);
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
 
 	return texture;
 }
 
+// Used for rendering directly into the pixels of a streaming texture,
+// or of the 'area' thereof if specified. 'pixels' is NULL if the texture
+// could not be locked, or if its format is not a 32-bit format with
+// 8-bit color components.
+class TextureLock {
+	SDL_Texture *texture;
 
-SDL_Texture *spnlib_sdl2_linear_gradient(
-	SDL_Renderer *renderer,
+public:
+	Uint32 *pixels;
+	int pitch; // in pixels, not in bytes
+	int width, height;
+	PixelLayout layout;
+
+	TextureLock(SDL_Texture *tex, const SDL_Rect *area = NULL) : texture(tex), pixels(NULL), pitch(0), width(0), height(0)
+	{
+		Uint32 format;
+		int access;
+
+		if (SDL_QueryTexture(texture, &format, &access, &width, &height) < 0
+		 || access != SDL_TEXTUREACCESS_STREAMING
+		 || !layout_for_format(format, &layout)) {
+			return;
+		}
+
+		if (area) {
+			width = area->w;
+			height = area->h;
+		}
+
+		void *raw;
+		int bytes_per_row;
+		if (SDL_LockTexture(texture, area, &raw, &bytes_per_row) < 0) {
+			return;
+		}
+
+		pixels = static_cast<Uint32 *>(raw);
+		pitch = bytes_per_row / sizeof pixels[0];
+	}
+
+	~TextureLock()
+	{
+		if (pixels) {
+			SDL_UnlockTexture(texture);
+		}
+	}
+};
+
+// Computes a linear gradient over the pixels of a w * h rectangle.
+// 'pitch' is the distance between the beginnings of rows, in pixels.
+template<typename ColorSource>
+static void fill_linear_gradient(
+	Uint32 *pixels,
+	int pitch,
 	int w,
 	int h,
 	double vx,
 	double vy,
-	const SPN_SDL_ColorStop color_stops[],
-	unsigned n
+	const ColorSource &color
 )
 {
-	// negative width/height make no sense
-	if (w < 0 || h < 0) {
-		return NULL;
-	}
-
-	// direction vector cannot be null vector
-	if (vx == 0 && vy == 0) {
-		return NULL;
-	}
-
-	// at least 2 color stop points (start, end) are required
-	if (n < 2) {
-		return NULL;
-	}
-
-	// Save original drawing color
-	RenderColorGuard cg(renderer);
-
-	// Prepare pixel buffer
-	std::vector<Uint32> buf;
-	buf.reserve(w * h);
-
 	// compute length of pivot color line clipped to bounds.
 	// treat infinities correctly, avoid division by zero.
 	bool pivot_is_steep = std::abs(vy * w) > std::abs(vx * h);
@@ -228,6 +360,8 @@ SDL_Texture *spnlib_sdl2_linear_gradient(
 	double c_coeff = (vx * w + vy * h) / 2;
 
 	for (int y = 0; y < h; y++) {
+		Uint32 *row = pixels + y * pitch;
+
 		for (int x = 0; x < w; x++) {
 			// progress along the pivot color line is the ratio of
 			// the _signed_ distance of the point (x, y) from the
@@ -241,22 +375,208 @@ SDL_Texture *spnlib_sdl2_linear_gradient(
 			double p = 0.5 + dist / pivot_length;
 
 			// interpolate between neighboring color stops
-			Uint32 c = interpolate_color_rgba32(color_stops, n, p);
-			buf.push_back(c);
+			row[x] = color(p);
 		}
 	}
+}
+
+// M_PI isn't part of standard C++
+static const double pi = 4 * std::atan(1);
+
+// atan(t) for 0 <= t <= 1, with an absolute error of about 1e-5 radians
+// (Abramowitz & Stegun, 4.4.49). Plenty for indexing a color table.
+static inline double atan_01(double t)
+{
+	double tt = t * t;
+	return t * (0.9998660 + tt * (-0.3302995 + tt * (0.1801410 + tt * (-0.0851330 + tt * 0.0208351))));
+}
 
-	// render prepared pixel array
+// atan2(y, x) for x, y >= 0, i. e. an angle in [0, pi / 2],
+// reduced to the first octant so that the polynomial converges
+static inline double atan2_first_quadrant(double y, double x)
+{
+	if (y <= x) {
+		return x > 0 ? atan_01(y / x) : 0;
+	}
+
+	return pi / 2 - atan_01(x / y);
+}
+
+// Approximation of std::atan2() with the same error bound as atan_01()
+static inline double fast_atan2(double y, double x)
+{
+	double phi = atan2_first_quadrant(std::abs(y), std::abs(x));
+
+	if (x < 0) {
+		phi = pi - phi;
+	}
+
+	return y < 0 ? -phi : phi;
+}
+
+// Computes a radial or conical gradient inscribed in the w * h rectangle.
+// Pixels outside the ellipse are made transparent.
+template<typename ColorSource>
+static void fill_ellipsoidal_gradient(
+	Uint32 *pixels,
+	int pitch,
+	int w,
+	int h,
+	bool isRadial,
+	const ColorSource &color
+)
+{
+	// every supported layout has all-zero transparent black
+	const Uint32 transparent = 0;
+
+	// the ellipse is inscribed in the w * h box, and pixels are
+	// sampled at their centers, so that the box is symmetric to
+	// both axes of the ellipse: pixel (i, j) is mirrored onto
+	// (w - 1 - i, j), (i, h - 1 - j) and (w - 1 - i, h - 1 - j).
+	// Only the top left quadrant is computed.
+	const double rx = w / 2.0, ry = h / 2.0;
+	const int half_w = (w + 1) / 2, half_h = (h + 1) / 2;
+
+	for (int j = 0; j < half_h; j++) {
+		Uint32 *top = pixels + j * pitch;
+		Uint32 *bottom = pixels + (h - 1 - j) * pitch;
+
+		// y, and later x, are normalized to the semi-axes,
+		// so that the ellipse becomes the unit circle
+		double y = (j + 0.5 - ry) / ry;
+		double yy = y * y;
+
+		// the pixels whose centers are at most 'extent' away
+		// from the vertical axis are inside the ellipse
+		double extent = yy < 1 ? rx * std::sqrt(1 - yy) : -1;
+		int begin = std::max(0, int(std::ceil(rx - extent - 0.5)));
+
+		if (begin >= half_w) {
+			std::fill(top, top + w, transparent);
+			std::fill(bottom, bottom + w, transparent);
+			continue;
+		}
+
+		std::fill(top, top + begin, transparent);
+		std::fill(top + w - begin, top + w, transparent);
+		std::fill(bottom, bottom + begin, transparent);
+		std::fill(bottom + w - begin, bottom + w, transparent);
+
+		if (isRadial) {
+			// the color-stop progress is the normalized radius
+			for (int i = begin; i < half_w; i++) {
+				double x = (i + 0.5 - rx) / rx;
+				Uint32 c = color(std::sqrt(x * x + yy));
+
+				top[i] = top[w - 1 - i] = c;
+				bottom[i] = bottom[w - 1 - i] = c;
+			}
+		} else {
+			// the color-stop progress is the normalized (divided-by-two-pi)
+			// direction angle atan2(y, x) + pi. With phi = atan2(|y|, |x|),
+			// the angle is pi - phi, -phi, phi - pi, phi in the four quadrants.
+			// The points on the axes are written by the bottom and right
+			// quadrants last, consistently with the sign rules of atan2().
+			const double tau = 2 * pi;
+			double ay = std::abs(j + 0.5 - ry) / ry;
+
+			for (int i = begin; i < half_w; i++) {
+				double ax = std::abs(i + 0.5 - rx) / rx;
+				double phi = atan2_first_quadrant(ay, ax);
+
+				top[i]            = color(phi / tau);
+				top[w - 1 - i]    = color((pi - phi) / tau);
+				bottom[i]         = color((tau - phi) / tau);
+				bottom[w - 1 - i] = color((pi + phi) / tau);
+			}
+		}
+	}
+}
+
+// Renders a gradient of any kind into a new w * h texture.
+// Radial and conical gradients are inscribed in the texture.
+// Horizontal and vertical linear gradients only vary along one axis,
+// so for them, only a single row or column is rendered, which is
+// then to be stretched to w * h when rendering the texture.
+template<typename ColorSource>
+static SDL_Texture *generate_gradient(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	SPN_SDL_GradientKind kind,
+	int w,
+	int h,
+	double vx,
+	double vy,
+	const ColorSource &color
+)
+{
+	if (kind == SPN_SDL_GRADIENT_LINEAR) {
+		if (vy == 0) {
+			h = std::min(h, 1);
+		} else if (vx == 0) {
+			w = std::min(w, 1);
+		}
+	}
+
+	// Save original drawing color
+	RenderColorGuard cg(renderer);
+
+	// Prepare pixel buffer
+	std::vector<Uint32> buf(w * h);
+
+	if (kind == SPN_SDL_GRADIENT_LINEAR) {
+		fill_linear_gradient(buf.data(), w, w, h, vx, vy, color);
+	} else {
+		bool isRadial = kind == SPN_SDL_GRADIENT_RADIAL;
+		fill_ellipsoidal_gradient(buf.data(), w, w, h, isRadial, color);
+	}
+
+	// blit pixels at once
 	return renderPixelBuffer(
 		renderer,
 		buf,
 		w,
-		h
+		h,
+		format
 	);
 }
 
+SDL_Texture *spnlib_sdl2_linear_gradient(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	int w,
+	int h,
+	double vx,
+	double vy,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+)
+{
+	// negative width/height make no sense
+	if (w < 0 || h < 0) {
+		return NULL;
+	}
+
+	// direction vector cannot be null vector
+	if (vx == 0 && vy == 0) {
+		return NULL;
+	}
+
+	// at least 2 color stop points (start, end) are required
+	if (n < 2) {
+		return NULL;
+	}
+
+	PixelLayout layout;
+	format = gradient_format(format, &layout);
+
+	StopsColorSource color = { color_stops, n, layout };
+	return generate_gradient(renderer, format, SPN_SDL_GRADIENT_LINEAR, w, h, vx, vy, color);
+}
+
 static SDL_Texture *spnlib_sdl2_ellipsoidal_gradient(
 	SDL_Renderer *renderer,
+	Uint32 format,
 	int rx,
 	int ry,
 	const SPN_SDL_ColorStop color_stops[],
@@ -274,43 +594,17 @@ static SDL_Texture *spnlib_sdl2_ellipsoidal_gradient(
 		return NULL;
 	}
 
-	// Save original drawing color
-	RenderColorGuard cg(renderer);
+	PixelLayout layout;
+	format = gradient_format(format, &layout);
 
-	// prepare buffer with transparent pixels
-	std::vector<Uint32> buf(2 * rx * 2 * ry, RGBA32(0, 0, 0, 0));
-
-	for (int y = -ry; y < +ry; y++) {
-		for (int x = -rx; x < +rx; x++) {
-			// check if point is within ellipse
-			// r = normalized "radius"
-			double r = std::sqrt(double(x * x) / (rx * rx) + double(y * y) / (ry * ry));
-			if (r > 1) {
-				continue;
-			}
-
-			// for a radial gradient, the color-stop progress is the normalized radius.
-			// for a conical one, it is the normalized (divided-by-two-pi) direction angle.
-			const double pi = 4 * std::atan(1), tau = 2 * pi;
-			double p = isRadial ? r : (std::atan2(y, x) + pi) / tau;
-
-			// interpolate between colors
-			Uint32 c = interpolate_color_rgba32(color_stops, n, p);
-			buf[2 * rx * (ry + y) + rx + x] = c;
-		}
-	}
-
-	// blit pixels at once
-	return renderPixelBuffer(
-		renderer,
-		buf,
-		2 * rx,
-		2 * ry
-	);
+	StopsColorSource color = { color_stops, n, layout };
+	SPN_SDL_GradientKind kind = isRadial ? SPN_SDL_GRADIENT_RADIAL : SPN_SDL_GRADIENT_CONICAL;
+	return generate_gradient(renderer, format, kind, 2 * rx, 2 * ry, 0, 0, color);
 }
 
 SDL_Texture *spnlib_sdl2_radial_gradient(
 	SDL_Renderer *renderer,
+	Uint32 format,
 	int rx,
 	int ry,
 	const SPN_SDL_ColorStop color_stops[],
@@ -319,6 +613,7 @@ SDL_Texture *spnlib_sdl2_radial_gradient(
 {
 	return spnlib_sdl2_ellipsoidal_gradient(
 		renderer,
+		format,
 		rx,
 		ry,
 		color_stops,
@@ -329,6 +624,7 @@ SDL_Texture *spnlib_sdl2_radial_gradient(
 
 SDL_Texture *spnlib_sdl2_conical_gradient(
 	SDL_Renderer *renderer,
+	Uint32 format,
 	int rx,
 	int ry,
 	const SPN_SDL_ColorStop color_stops[],
@@ -337,6 +633,7 @@ SDL_Texture *spnlib_sdl2_conical_gradient(
 {
 	return spnlib_sdl2_ellipsoidal_gradient(
 		renderer,
+		format,
 		rx,
 		ry,
 		color_stops,
@@ -344,3 +641,743 @@ SDL_Texture *spnlib_sdl2_conical_gradient(
 		false
 	);
 }
+
+//
+// Rendering into streaming textures
+//
+
+bool spnlib_sdl2_linear_gradient_into(
+	SDL_Texture *texture,
+	double vx,
+	double vy,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+)
+{
+	// same constraints as in spnlib_sdl2_linear_gradient()
+	if ((vx == 0 && vy == 0) || n < 2) {
+		return false;
+	}
+
+	TextureLock lock(texture);
+	if (lock.pixels == NULL) {
+		return false;
+	}
+
+	fill_linear_gradient(
+		lock.pixels,
+		lock.pitch,
+		lock.width,
+		lock.height,
+		vx,
+		vy,
+		StopsColorSource { color_stops, n, lock.layout }
+	);
+
+	return true;
+}
+
+static bool spnlib_sdl2_ellipsoidal_gradient_into(
+	SDL_Texture *texture,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n,
+	bool isRadial
+)
+{
+	if (n < 2) {
+		return false;
+	}
+
+	TextureLock lock(texture);
+	if (lock.pixels == NULL) {
+		return false;
+	}
+
+	// the ellipse is inscribed in the texture
+	fill_ellipsoidal_gradient(
+		lock.pixels,
+		lock.pitch,
+		lock.width,
+		lock.height,
+		isRadial,
+		StopsColorSource { color_stops, n, lock.layout }
+	);
+
+	return true;
+}
+
+bool spnlib_sdl2_radial_gradient_into(
+	SDL_Texture *texture,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+)
+{
+	return spnlib_sdl2_ellipsoidal_gradient_into(texture, color_stops, n, true);
+}
+
+bool spnlib_sdl2_conical_gradient_into(
+	SDL_Texture *texture,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+)
+{
+	return spnlib_sdl2_ellipsoidal_gradient_into(texture, color_stops, n, false);
+}
+
+//
+// Gradient texture cache
+//
+
+// A gradient texture is fully determined by its kind, its size,
+// its unit direction vector (only meaningful for linear gradients),
+// its (sorted) list of color stops and whether its colors were
+// looked up in the table of a Gradient object.
+struct GradientKey {
+	SPN_SDL_GradientKind kind;
+	int w, h;
+	double vx, vy;
+	std::vector<SPN_SDL_ColorStop> stops;
+	bool lut;
+
+	bool operator==(const GradientKey &that) const {
+		if (kind != that.kind || w != that.w || h != that.h
+		 || vx != that.vx || vy != that.vy || lut != that.lut
+		 || stops.size() != that.stops.size()) {
+			return false;
+		}
+
+		return std::equal(
+			stops.begin(),
+			stops.end(),
+			that.stops.begin(),
+			[](const SPN_SDL_ColorStop &cs1, const SPN_SDL_ColorStop &cs2) {
+				return cs1.progress == cs2.progress
+				    && cs1.color.r == cs2.color.r
+				    && cs1.color.g == cs2.color.g
+				    && cs1.color.b == cs2.color.b
+				    && cs1.color.a == cs2.color.a;
+			}
+		);
+	}
+};
+
+struct GradientKeyHash {
+	std::size_t operator()(const GradientKey &key) const {
+		std::size_t seed = std::hash<int>()(key.kind);
+		texture_cache_hash_combine(seed, std::hash<int>()(key.w));
+		texture_cache_hash_combine(seed, std::hash<int>()(key.h));
+		texture_cache_hash_combine(seed, std::hash<double>()(key.vx));
+		texture_cache_hash_combine(seed, std::hash<double>()(key.vy));
+		texture_cache_hash_combine(seed, std::hash<bool>()(key.lut));
+
+		for (const auto &cs : key.stops) {
+			texture_cache_hash_combine(seed, std::hash<double>()(cs.progress));
+			texture_cache_hash_combine(seed, RGBA32(cs.color.r, cs.color.g, cs.color.b, cs.color.a));
+		}
+
+		return seed;
+	}
+};
+
+// Least-recently-used cache of gradient textures belonging
+// to one renderer, bounded by the total size of the textures
+// in bytes. A capacity of 0 disables caching altogether.
+typedef TextureCache<GradientKey, GradientKeyHash> GradientCache;
+
+// Per-renderer state of the gradient module
+class RendererState {
+	// streaming texture used for painting shapes
+	SDL_Texture *scratch;
+	int scratch_w, scratch_h;
+
+public:
+	GradientCache cache;
+
+	RendererState() : scratch(NULL), scratch_w(0), scratch_h(0) {}
+
+	RendererState(const RendererState &) = delete;
+	RendererState &operator=(const RendererState &) = delete;
+
+	~RendererState()
+	{
+		if (scratch) {
+			SDL_DestroyTexture(scratch);
+		}
+	}
+
+	// Returns a streaming texture of size at least w * h
+	SDL_Texture *scratch_texture(SDL_Renderer *renderer, Uint32 format, int w, int h)
+	{
+		if (scratch && scratch_w >= w && scratch_h >= h) {
+			return scratch;
+		}
+
+		if (scratch) {
+			SDL_DestroyTexture(scratch);
+		}
+
+		// grow monotonically in both dimensions so that
+		// alternating shapes don't reallocate every time
+		scratch_w = std::max(w, scratch_w);
+		scratch_h = std::max(h, scratch_h);
+		scratch = SDL_CreateTexture(
+			renderer,
+			format,
+			SDL_TEXTUREACCESS_STREAMING,
+			scratch_w,
+			scratch_h
+		);
+
+		if (scratch == NULL) {
+			scratch_w = scratch_h = 0;
+			return NULL;
+		}
+
+		SDL_SetTextureBlendMode(scratch, SDL_BLENDMODE_BLEND);
+		return scratch;
+	}
+};
+
+// Textures are only valid in conjunction with the renderer that
+// created them, hence every renderer has its own cache.
+static std::unordered_map<SDL_Renderer *, RendererState> renderer_states;
+
+void spnlib_sdl2_gradient_cache_set_capacity(SDL_Renderer *renderer, size_t bytes)
+{
+	renderer_states[renderer].cache.set_capacity(bytes);
+}
+
+void spnlib_sdl2_gradient_cache_purge(SDL_Renderer *renderer)
+{
+	auto it = renderer_states.find(renderer);
+	if (it != renderer_states.end()) {
+		it->second.cache.purge();
+	}
+}
+
+void spnlib_sdl2_gradient_release_renderer(SDL_Renderer *renderer)
+{
+	renderer_states.erase(renderer);
+}
+
+// Looks up the texture described by 'key' in the cache of 'renderer'.
+// If it is not found, it is generated using 'generate' and then inserted.
+// Returns a new reference (the caller is responsible for releasing it).
+static spn_SDL_Texture *cached_gradient(
+	SDL_Renderer *renderer,
+	GradientKey &&key,
+	const std::function<SDL_Texture *()> &generate
+)
+{
+	// the length of the direction doesn't affect the texture,
+	// so parallel directions share a cache entry
+	if (key.kind == SPN_SDL_GRADIENT_LINEAR) {
+		// a null vector is rejected by the generator
+		double norm = std::sqrt(key.vx * key.vx + key.vy * key.vy);
+		if (norm > 0) {
+			key.vx /= norm;
+			key.vy /= norm;
+		}
+	} else {
+		key.vx = key.vy = 0;
+	}
+
+	auto it = renderer_states.find(renderer);
+	GradientCache *cache = it != renderer_states.end() && it->second.cache.get_capacity() > 0
+	                     ? &it->second.cache
+	                     : NULL;
+
+	if (cache) {
+		spn_SDL_Texture *texture = cache->lookup(key);
+		if (texture) {
+			spn_object_retain(texture);
+			return texture;
+		}
+	}
+
+	SDL_Texture *raw = generate();
+	if (raw == NULL) {
+		return NULL;
+	}
+
+	// the texture may be smaller than its logical size (see generate_gradient())
+	spn_SDL_Texture *texture = spnlib_SDL_texture_new_sized(raw, key.w, key.h);
+
+	if (cache) {
+		int w = 0, h = 0;
+		SDL_QueryTexture(raw, NULL, NULL, &w, &h);
+		std::size_t bytes = std::size_t(w) * std::size_t(h) * sizeof(Uint32);
+		cache->insert(key, texture, bytes);
+	}
+
+	return texture;
+}
+
+spn_SDL_Texture *spnlib_sdl2_cached_linear_gradient(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	int w,
+	int h,
+	double vx,
+	double vy,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+)
+{
+	return cached_gradient(
+		renderer,
+		{ SPN_SDL_GRADIENT_LINEAR, w, h, vx, vy, { color_stops, color_stops + n }, false },
+		[=] {
+			return spnlib_sdl2_linear_gradient(renderer, format, w, h, vx, vy, color_stops, n);
+		}
+	);
+}
+
+spn_SDL_Texture *spnlib_sdl2_cached_radial_gradient(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	int rx,
+	int ry,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+)
+{
+	return cached_gradient(
+		renderer,
+		{ SPN_SDL_GRADIENT_RADIAL, 2 * rx, 2 * ry, 0, 0, { color_stops, color_stops + n }, false },
+		[=] {
+			return spnlib_sdl2_radial_gradient(renderer, format, rx, ry, color_stops, n);
+		}
+	);
+}
+
+spn_SDL_Texture *spnlib_sdl2_cached_conical_gradient(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	int rx,
+	int ry,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+)
+{
+	return cached_gradient(
+		renderer,
+		{ SPN_SDL_GRADIENT_CONICAL, 2 * rx, 2 * ry, 0, 0, { color_stops, color_stops + n }, false },
+		[=] {
+			return spnlib_sdl2_conical_gradient(renderer, format, rx, ry, color_stops, n);
+		}
+	);
+}
+
+//
+// Gradient objects
+//
+
+static void spn_SDL_Gradient_dtor(void *obj)
+{
+	spn_SDL_Gradient *gradient = static_cast<spn_SDL_Gradient *>(obj);
+	delete[] gradient->color_stops;
+}
+
+const SpnClass spn_SDL_Gradient_class = {
+	sizeof(spn_SDL_Gradient),
+	SPN_SDL_CLASS_UID_GRADIENT,
+	NULL,
+	NULL,
+	NULL,
+	spn_SDL_Gradient_dtor
+};
+
+spn_SDL_Gradient *spnlib_sdl2_gradient_new(
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+)
+{
+	// at least 2 color stop points (start, end) are required
+	if (n < 2) {
+		return NULL;
+	}
+
+	spn_SDL_Gradient *gradient = static_cast<spn_SDL_Gradient *>(
+		spn_object_new(&spn_SDL_Gradient_class)
+	);
+
+	gradient->color_stops = new SPN_SDL_ColorStop[n];
+	gradient->n = n;
+	std::copy(color_stops, color_stops + n, gradient->color_stops);
+
+	for (int i = 0; i < SPN_SDL_GRADIENT_LUT_SIZE; i++) {
+		double p = double(i) / (SPN_SDL_GRADIENT_LUT_SIZE - 1);
+		gradient->lut[i] = interpolate_color(color_stops, n, p);
+	}
+
+	return gradient;
+}
+
+spn_SDL_Gradient *spnlib_sdl2_gradient_from_value(const SpnValue *val)
+{
+	if (!spn_isstrguserinfo(val)) {
+		return NULL;
+	}
+
+	void *obj = spn_objvalue(val);
+	if (!spn_object_member_of_class(obj, &spn_SDL_Gradient_class)) {
+		return NULL;
+	}
+
+	return static_cast<spn_SDL_Gradient *>(obj);
+}
+
+// Parses color stops once into a Gradient object, which can then be
+// passed to the gradient methods in place of the array of color stops,
+// and used for filling shapes (see Window::setFillGradient()).
+// Parameters:
+// 0. array of color stops
+int spnlib_SDL_CreateGradient(SpnValue *ret, int argc, SpnValue *argv, void *context)
+{
+	// C++ doesn't convert 'void *' implicitly, as the macros would need
+	SpnContext *ctx = static_cast<SpnContext *>(context);
+
+	CHECK_ARG_RETURN_ON_ERROR(0, array);
+
+	SpnArray *arr = ARRAYARG(0);
+	std::vector<SPN_SDL_ColorStop> color_stops(spn_array_count(arr));
+	bool success = spnlib_sdl2_array_to_colorstop(arr, color_stops.data());
+
+	if (!success) {
+		spn_ctx_runtime_error(ctx, "invalid color stop specification", NULL);
+		return -1;
+	}
+
+	spn_SDL_Gradient *gradient = spnlib_sdl2_gradient_new(color_stops.data(), color_stops.size());
+
+	if (gradient == NULL) {
+		spn_ctx_runtime_error(ctx, "at least 2 color stops are required", NULL);
+		return -2;
+	}
+
+	*ret = spn_makestrguserinfo(gradient);
+	return 0;
+}
+
+spn_SDL_Texture *spnlib_sdl2_gradient_texture(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const spn_SDL_Gradient *gradient,
+	SPN_SDL_GradientKind kind,
+	int w,
+	int h,
+	double vx,
+	double vy
+)
+{
+	// same constraints as for the color stop-based functions
+	if (w < 0 || h < 0) {
+		return NULL;
+	}
+
+	if (kind == SPN_SDL_GRADIENT_LINEAR && vx == 0 && vy == 0) {
+		return NULL;
+	}
+
+	const SPN_SDL_ColorStop *color_stops = gradient->color_stops;
+
+	return cached_gradient(
+		renderer,
+		{ kind, w, h, vx, vy, { color_stops, color_stops + gradient->n }, true },
+		[=] {
+			PixelLayout layout;
+			Uint32 native = gradient_format(format, &layout);
+
+			LutColorSource color(gradient, layout);
+			return generate_gradient(renderer, native, kind, w, h, vx, vy, color);
+		}
+	);
+}
+
+bool spnlib_sdl2_gradient_render_into(
+	SDL_Texture *texture,
+	const spn_SDL_Gradient *gradient,
+	SPN_SDL_GradientKind kind,
+	double vx,
+	double vy
+)
+{
+	if (kind == SPN_SDL_GRADIENT_LINEAR && vx == 0 && vy == 0) {
+		return false;
+	}
+
+	TextureLock lock(texture);
+	if (lock.pixels == NULL) {
+		return false;
+	}
+
+	LutColorSource color(gradient, lock.layout);
+
+	if (kind == SPN_SDL_GRADIENT_LINEAR) {
+		fill_linear_gradient(lock.pixels, lock.pitch, lock.width, lock.height, vx, vy, color);
+	} else {
+		fill_ellipsoidal_gradient(
+			lock.pixels,
+			lock.pitch,
+			lock.width,
+			lock.height,
+			kind == SPN_SDL_GRADIENT_RADIAL,
+			color
+		);
+	}
+
+	return true;
+}
+
+//
+// Painting shapes with gradients
+//
+
+// Maps a point in window coordinates to a color-stop progress value
+class PaintMapping {
+	SPN_SDL_GradientKind kind;
+	double x0, y0;
+	double ax, ay; // direction scaled by inverse squared length, or inverse semi-axes
+
+public:
+	PaintMapping(const SPN_SDL_GradientPaint *paint) :
+		kind(paint->kind),
+		x0(paint->x0),
+		y0(paint->y0),
+		ax(0),
+		ay(0)
+	{
+		switch (kind) {
+		case SPN_SDL_GRADIENT_LINEAR: {
+			// progress is the length of the projection of the point
+			// onto the line from (x0, y0) to (x1, y1), relative to
+			// the length of that line. A zero-length line yields 0.
+			double dx = paint->x1 - paint->x0;
+			double dy = paint->y1 - paint->y0;
+			double len2 = dx * dx + dy * dy;
+
+			if (len2 > 0) {
+				ax = dx / len2;
+				ay = dy / len2;
+			}
+			break;
+		}
+		case SPN_SDL_GRADIENT_RADIAL:
+			ax = paint->x1 != 0 ? 1 / paint->x1 : 0;
+			ay = paint->y1 != 0 ? 1 / paint->y1 : 0;
+			break;
+		case SPN_SDL_GRADIENT_CONICAL:
+			break;
+		}
+	}
+
+	double operator()(double x, double y) const {
+		x -= x0;
+		y -= y0;
+
+		switch (kind) {
+		case SPN_SDL_GRADIENT_LINEAR:
+			return ax * x + ay * y;
+		case SPN_SDL_GRADIENT_RADIAL:
+			return std::sqrt(ax * ax * x * x + ay * ay * y * y);
+		case SPN_SDL_GRADIENT_CONICAL:
+		default:
+			return (fast_atan2(y, x) + pi) / (2 * pi);
+		}
+	}
+};
+
+// A horizontal run of covered pixels, in window coordinates.
+// A pixel belongs to the span if its center lies in [left, right).
+struct Span {
+	double left, right;
+};
+
+// Fills the shape enclosed by 'bounds' with 'paint'. The shape is
+// described by 'spans_of_row', which is called with the vertical
+// coordinate of the center of each pixel row, and which appends
+// the spans the shape covers in that row to its second argument.
+// The pixels are computed into the scratch texture of the renderer,
+// which is then blended onto the render target in one go.
+template<typename SpanFunc>
+static void paint_shape(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const SPN_SDL_GradientPaint *paint,
+	SDL_Rect bounds,
+	SpanFunc spans_of_row
+)
+{
+	// there's no point in computing pixels that are never seen
+	int out_w, out_h;
+	if (SDL_GetRendererOutputSize(renderer, &out_w, &out_h) < 0) {
+		return;
+	}
+
+	SDL_Rect output = { 0, 0, out_w, out_h };
+	SDL_Rect area;
+	if (!SDL_IntersectRect(&bounds, &output, &area)) {
+		return;
+	}
+
+	// the scratch texture is rendered into directly, so
+	// it must be in a format gradients can be computed in
+	PixelLayout layout;
+	Uint32 scratch_format = gradient_format(format, &layout);
+
+	SDL_Texture *scratch = renderer_states[renderer].scratch_texture(renderer, scratch_format, area.w, area.h);
+	if (scratch == NULL) {
+		return;
+	}
+
+	SDL_Rect src = { 0, 0, area.w, area.h };
+
+	{
+		TextureLock lock(scratch, &src);
+		if (lock.pixels == NULL) {
+			return;
+		}
+
+		LutColorSource color(paint->gradient, lock.layout);
+		PaintMapping progress(paint);
+		std::vector<Span> spans;
+
+		for (int j = 0; j < area.h; j++) {
+			Uint32 *row = lock.pixels + j * lock.pitch;
+			double y = area.y + j + 0.5;
+
+			std::fill(row, row + area.w, Uint32(0));
+
+			spans.clear();
+			spans_of_row(y, spans);
+
+			for (const Span &span : spans) {
+				// indices of the first and one past the last
+				// pixel whose center is inside the span
+				int begin = std::max(0, int(std::ceil(span.left - 0.5)) - area.x);
+				int end = std::min(area.w, int(std::ceil(span.right - 0.5)) - area.x);
+
+				for (int i = begin; i < end; i++) {
+					row[i] = color(progress(area.x + i + 0.5, y));
+				}
+			}
+		}
+	}
+
+	SDL_RenderCopy(renderer, scratch, &src, &area);
+}
+
+void spnlib_sdl2_paint_rect(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const SPN_SDL_GradientPaint *paint,
+	int x,
+	int y,
+	int w,
+	int h
+)
+{
+	if (w <= 0 || h <= 0) {
+		return;
+	}
+
+	paint_shape(renderer, format, paint, { x, y, w, h }, [=](double, std::vector<Span> &spans) {
+		spans.push_back({ double(x), double(x + w) });
+	});
+}
+
+void spnlib_sdl2_paint_ellipse(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const SPN_SDL_GradientPaint *paint,
+	int x,
+	int y,
+	int rx,
+	int ry
+)
+{
+	if (rx < 0 || ry < 0) {
+		return;
+	}
+
+	// like SDL2_gfx, include the pixels on both ends of the axes,
+	// i. e. the ellipse is centered at the center of pixel (x, y)
+	// and its semi-axes are extended by half a pixel.
+	double cx = x + 0.5, cy = y + 0.5;
+	double ax = rx + 0.5, ay = ry + 0.5;
+	SDL_Rect bounds = { x - rx, y - ry, 2 * rx + 1, 2 * ry + 1 };
+
+	paint_shape(renderer, format, paint, bounds, [=](double py, std::vector<Span> &spans) {
+		double dy = (py - cy) / ay;
+		if (dy * dy <= 1) {
+			double half = ax * std::sqrt(1 - dy * dy);
+			spans.push_back({ cx - half, cx + half });
+		}
+	});
+}
+
+void spnlib_sdl2_paint_rounded_rect(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const SPN_SDL_GradientPaint *paint,
+	int x,
+	int y,
+	int w,
+	int h,
+	int r
+)
+{
+	if (w <= 0 || h <= 0) {
+		return;
+	}
+
+	// the corners can't be rounder than the rectangle itself
+	double radius = std::max(0.0, std::min(double(r), std::min(w, h) / 2.0));
+	double top = y + radius, bottom = y + h - radius;
+
+	paint_shape(renderer, format, paint, { x, y, w, h }, [=](double py, std::vector<Span> &spans) {
+		double dy = py < top ? top - py : py > bottom ? py - bottom : 0;
+		double inset = radius - std::sqrt(std::max(0.0, radius * radius - dy * dy));
+		spans.push_back({ x + inset, x + w - inset });
+	});
+}
+
+void spnlib_sdl2_paint_polygon(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const SPN_SDL_GradientPaint *paint,
+	const Sint16 vx[],
+	const Sint16 vy[],
+	int n
+)
+{
+	if (n < 3) {
+		return;
+	}
+
+	int xmin = *std::min_element(vx, vx + n), xmax = *std::max_element(vx, vx + n);
+	int ymin = *std::min_element(vy, vy + n), ymax = *std::max_element(vy, vy + n);
+	SDL_Rect bounds = { xmin, ymin, xmax - xmin + 1, ymax - ymin + 1 };
+
+	// even-odd rule, same as SDL2_gfx's filledPolygon
+	paint_shape(renderer, format, paint, bounds, [=](double py, std::vector<Span> &spans) {
+		std::vector<double> crossings;
+
+		for (int i = 0, j = n - 1; i < n; j = i++) {
+			double y0 = vy[j], y1 = vy[i];
+
+			// half-open test, so that vertices are not counted twice
+			if ((y0 <= py) != (y1 <= py)) {
+				double x0 = vx[j], x1 = vx[i];
+				crossings.push_back(x0 + (py - y0) * (x1 - x0) / (y1 - y0));
+			}
+		}
+
+		std::sort(crossings.begin(), crossings.end());
+
+		for (std::size_t i = 0; i + 1 < crossings.size(); i += 2) {
+			spans.push_back({ crossings[i], crossings[i + 1] });
+		}
+	});
+}
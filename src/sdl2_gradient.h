@@ -15,18 +15,64 @@
 #include <spn/array.h>
 #include <SDL2/SDL.h>
 
+#include "sdl2_texture.h"
+
 typedef struct SPN_SDL_ColorStop {
 	SDL_Color color;
 	double progress;
 } SPN_SDL_ColorStop;
 
+typedef enum SPN_SDL_GradientKind {
+	SPN_SDL_GRADIENT_LINEAR,
+	SPN_SDL_GRADIENT_RADIAL,
+	SPN_SDL_GRADIENT_CONICAL
+} SPN_SDL_GradientKind;
+
+// number of entries in the color lookup table of a Gradient object
+#define SPN_SDL_GRADIENT_LUT_SIZE 1024
+
+// A set of color stops, parsed and sorted once, along with a lookup
+// table of the colors at evenly spaced progress values. The same
+// object can be rendered as a linear, radial or conical gradient of
+// any size, and it can be used for painting filled shapes.
+typedef struct spn_SDL_Gradient {
+	SpnObject base;
+	SPN_SDL_ColorStop *color_stops;
+	unsigned n;
+	SDL_Color lut[SPN_SDL_GRADIENT_LUT_SIZE];
+} spn_SDL_Gradient;
+
+SPN_API const SpnClass spn_SDL_Gradient_class;
+
+// Describes how a gradient is mapped onto the window when it is
+// used for filling shapes. For linear gradients, the gradient runs
+// from (x0, y0) to (x1, y1). For radial and conical gradients,
+// (x0, y0) is the center of the enclosing ellipse, and for radial
+// ones, x1 and y1 are the horizontal and vertical semi-axes.
+typedef struct SPN_SDL_GradientPaint {
+	spn_SDL_Gradient *gradient; // NULL if shapes are filled with a solid color
+	SPN_SDL_GradientKind kind;
+	double x0, y0, x1, y1;
+} SPN_SDL_GradientPaint;
+
 SPN_API bool spnlib_sdl2_array_to_colorstop(
 	SpnArray *arr,
 	SPN_SDL_ColorStop color_stops[]
 );
 
+// The functions that create textures take the preferred texture format
+// of the renderer (see spnlib_SDL_preferred_texture_format()), so that
+// pixels are generated in that format, and no conversion is needed when
+// uploading them. Formats other than 32-bit formats with 8-bit color
+// components fall back to ARGB8888.
+//
+// If (vx, vy) is horizontal or vertical, the returned texture is only
+// a single row or column of pixels, which should be stretched to w * h
+// when rendered. The cached variant below takes care of this by setting
+// the logical size of the resulting texture object.
 SPN_API SDL_Texture *spnlib_sdl2_linear_gradient(
 	SDL_Renderer *renderer,
+	Uint32 format,
 	int w,
 	int h,
 	double vx,
@@ -37,6 +83,7 @@ SPN_API SDL_Texture *spnlib_sdl2_linear_gradient(
 
 SPN_API SDL_Texture *spnlib_sdl2_radial_gradient(
 	SDL_Renderer *renderer,
+	Uint32 format,
 	int rx,
 	int ry,
 	const SPN_SDL_ColorStop color_stops[],
@@ -45,10 +92,159 @@ SPN_API SDL_Texture *spnlib_sdl2_radial_gradient(
 
 SPN_API SDL_Texture *spnlib_sdl2_conical_gradient(
 	SDL_Renderer *renderer,
+	Uint32 format,
+	int rx,
+	int ry,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+);
+
+// Variants of the functions above that render into an existing texture
+// created with SDL_TEXTUREACCESS_STREAMING instead of creating a new one.
+// The gradient covers the entire texture (radial and conical gradients
+// are inscribed in it), and pixels are written in the texture's own format,
+// which must be a 32-bit format with 8-bit color components (e. g. ARGB8888).
+// They return false if the texture can't be rendered into.
+SPN_API bool spnlib_sdl2_linear_gradient_into(
+	SDL_Texture *texture,
+	double vx,
+	double vy,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+);
+
+SPN_API bool spnlib_sdl2_radial_gradient_into(
+	SDL_Texture *texture,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+);
+
+SPN_API bool spnlib_sdl2_conical_gradient_into(
+	SDL_Texture *texture,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+);
+
+// Cached variants of the functions above. They return a new reference
+// to a texture object, which is shared with other callers if the same
+// gradient has already been generated for 'renderer'.
+// Caching is opt-in: it is disabled until a nonzero capacity is set.
+SPN_API spn_SDL_Texture *spnlib_sdl2_cached_linear_gradient(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	int w,
+	int h,
+	double vx,
+	double vy,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+);
+
+SPN_API spn_SDL_Texture *spnlib_sdl2_cached_radial_gradient(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	int rx,
+	int ry,
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+);
+
+SPN_API spn_SDL_Texture *spnlib_sdl2_cached_conical_gradient(
+	SDL_Renderer *renderer,
+	Uint32 format,
 	int rx,
 	int ry,
 	const SPN_SDL_ColorStop color_stops[],
 	unsigned n
 );
 
+// Copies the color stops and precomputes the lookup table.
+// 'color_stops' must be sorted (spnlib_sdl2_array_to_colorstop()
+// sorts them). Returns NULL if fewer than 2 color stops are given.
+SPN_API spn_SDL_Gradient *spnlib_sdl2_gradient_new(
+	const SPN_SDL_ColorStop color_stops[],
+	unsigned n
+);
+
+// Returns NULL if 'val' is not a Gradient object
+SPN_API spn_SDL_Gradient *spnlib_sdl2_gradient_from_value(const SpnValue *val);
+
+// SDL::CreateGradient()
+SPN_API int spnlib_SDL_CreateGradient(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+
+// Renders 'gradient' into a new (possibly cached) texture of size w * h.
+// (vx, vy) is the direction vector of linear gradients, ignored otherwise.
+// Returns a new reference, or NULL if the parameters are invalid.
+SPN_API spn_SDL_Texture *spnlib_sdl2_gradient_texture(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const spn_SDL_Gradient *gradient,
+	SPN_SDL_GradientKind kind,
+	int w,
+	int h,
+	double vx,
+	double vy
+);
+
+// Same as above, but renders into an existing streaming texture
+SPN_API bool spnlib_sdl2_gradient_render_into(
+	SDL_Texture *texture,
+	const spn_SDL_Gradient *gradient,
+	SPN_SDL_GradientKind kind,
+	double vx,
+	double vy
+);
+
+// Fill shapes with a gradient paint. The shapes cover the same
+// pixels as the corresponding SDL and SDL2_gfx primitives do.
+SPN_API void spnlib_sdl2_paint_rect(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const SPN_SDL_GradientPaint *paint,
+	int x,
+	int y,
+	int w,
+	int h
+);
+
+SPN_API void spnlib_sdl2_paint_ellipse(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const SPN_SDL_GradientPaint *paint,
+	int x,
+	int y,
+	int rx,
+	int ry
+);
+
+SPN_API void spnlib_sdl2_paint_rounded_rect(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const SPN_SDL_GradientPaint *paint,
+	int x,
+	int y,
+	int w,
+	int h,
+	int r
+);
+
+SPN_API void spnlib_sdl2_paint_polygon(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const SPN_SDL_GradientPaint *paint,
+	const Sint16 vx[],
+	const Sint16 vy[],
+	int n
+);
+
+// Sets the maximal total size (in bytes) of the cached
+// gradient textures of 'renderer'; 0 disables caching.
+SPN_API void spnlib_sdl2_gradient_cache_set_capacity(SDL_Renderer *renderer, size_t bytes);
+
+// Drops every cached gradient texture of 'renderer'
+SPN_API void spnlib_sdl2_gradient_cache_purge(SDL_Renderer *renderer);
+
+// Must be called before 'renderer' is destroyed
+SPN_API void spnlib_sdl2_gradient_release_renderer(SDL_Renderer *renderer);
+
 #endif // SPNLIB_SDL2_GRADIENT_H
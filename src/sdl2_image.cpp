@@ -9,9 +9,28 @@
 //
 
 #include "sdl2_image.h"
+#include "sdl2_event.h"
+#include "sdl2_texture_cache.h"
 
 #include <SDL2/SDL_image.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 static const struct IMG_InitGuard {
 	IMG_InitGuard() {
 		IMG_Init(IMG_INIT_JPG | IMG_INIT_PNG | IMG_INIT_TIF);
@@ -21,16 +40,646 @@ static const struct IMG_InitGuard {
 	}
 } initGuard;
 
+// Identifies the version of a file, so that modified files are reloaded
+// (with nanosecond resolution, so that quick successive writes are seen)
+struct FileStamp {
+	struct timespec mtime;
+	off_t size;
+
+	bool operator==(const FileStamp &that) const {
+		return mtime.tv_sec == that.mtime.tv_sec
+		    && mtime.tv_nsec == that.mtime.tv_nsec
+		    && size == that.size;
+	}
+};
+
+// Loaded images by canonical path (plus the options they were loaded
+// with), and the versions of the files they were loaded from.
+// A stamp lives exactly as long as the entry of its texture.
+struct ImageCache {
+	// declared first, so that it outlives the purge of 'textures'
+	std::unordered_map<std::string, FileStamp> stamps;
+	TextureCache<std::string, std::hash<std::string>> textures;
+
+	ImageCache()
+	{
+		textures.set_eviction_handler([this](const std::string &key) {
+			stamps.erase(key);
+		});
+	}
+};
+
+// textures belong to the renderer that created them
+static std::unordered_map<SDL_Renderer *, ImageCache> image_caches;
+
+// Source pixels covered by each destination pixel when resampling
+// along one axis, and the fraction of the destination pixel each covers
+static void box_taps(int src_size, int dst_size, std::vector<int> *start, std::vector<int> *count, std::vector<float> *weights)
+{
+	double scale = double(src_size) / dst_size;
+
+	for (int d = 0; d < dst_size; d++) {
+		double lo = d * scale;
+		double hi = lo + scale;
+		int s0 = int(lo);
+		int s1 = std::min(int(std::ceil(hi)), src_size);
+
+		start->push_back(s0);
+		count->push_back(s1 - s0);
+
+		for (int s = s0; s < s1; s++) {
+			double cover = std::min(hi, s + 1.0) - std::max(lo, double(s));
+			weights->push_back(float(cover / scale));
+		}
+	}
+}
+
+// Area-averaging downscaler: every destination pixel is the average
+// of the source pixels it covers, weighted by the covered area. Colors
+// are premultiplied by alpha while averaging, so transparent pixels
+// don't darken the edges of opaque ones. 'src' must be ARGB8888.
+static SDL_Surface *downscale(SDL_Surface *src, int w, int h)
+{
+	SDL_Surface *dst = SDL_CreateRGBSurface(0, w, h, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+	if (dst == nullptr) {
+		return nullptr;
+	}
+
+	std::vector<int> xstart, xcount, ystart, ycount;
+	std::vector<float> xweights, yweights;
+	box_taps(src->w, w, &xstart, &xcount, &xweights);
+	box_taps(src->h, h, &ystart, &ycount, &yweights);
+
+	// horizontal pass into premultiplied floats, h rows of w pixels
+	std::vector<float> rows(std::size_t(src->h) * w * 4);
+
+	for (int y = 0; y < src->h; y++) {
+		const Uint32 *in = reinterpret_cast<const Uint32 *>(static_cast<const Uint8 *>(src->pixels) + y * src->pitch);
+		float *out = &rows[std::size_t(y) * w * 4];
+		const float *weight = xweights.data();
+
+		for (int x = 0; x < w; x++) {
+			float a = 0, r = 0, g = 0, b = 0;
+
+			for (int i = 0; i < xcount[x]; i++, weight++) {
+				Uint32 p = in[xstart[x] + i];
+				float pa = (p >> 24) * *weight;
+				a += pa;
+				r += ((p >> 16) & 0xff) * pa;
+				g += ((p >> 8) & 0xff) * pa;
+				b += (p & 0xff) * pa;
+			}
+
+			out[x * 4 + 0] = a;
+			out[x * 4 + 1] = r;
+			out[x * 4 + 2] = g;
+			out[x * 4 + 3] = b;
+		}
+	}
+
+	// vertical pass, then back to straight alpha
+	std::vector<float> acc(std::size_t(w) * 4);
+	const float *weight = yweights.data();
+
+	for (int y = 0; y < h; y++) {
+		std::fill(acc.begin(), acc.end(), 0.0f);
+
+		for (int i = 0; i < ycount[y]; i++, weight++) {
+			const float *row = &rows[std::size_t(ystart[y] + i) * w * 4];
+
+			for (int j = 0; j < w * 4; j++) {
+				acc[j] += row[j] * *weight;
+			}
+		}
+
+		Uint32 *out = reinterpret_cast<Uint32 *>(static_cast<Uint8 *>(dst->pixels) + y * dst->pitch);
+
+		for (int x = 0; x < w; x++) {
+			float a = acc[x * 4 + 0];
+			float inv = a > 0 ? 1.0f / a : 0.0f;
+
+			Uint32 pa = Uint32(a + 0.5f);
+			Uint32 pr = Uint32(std::min(acc[x * 4 + 1] * inv + 0.5f, 255.0f));
+			Uint32 pg = Uint32(std::min(acc[x * 4 + 2] * inv + 0.5f, 255.0f));
+			Uint32 pb = Uint32(std::min(acc[x * 4 + 3] * inv + 0.5f, 255.0f));
+
+			out[x] = pa << 24 | pr << 16 | pg << 8 | pb;
+		}
+	}
+
+	return dst;
+}
+
+static bool renderer_supports_format(SDL_Renderer *renderer, Uint32 format)
+{
+	SDL_RendererInfo info;
+
+	if (SDL_GetRendererInfo(renderer, &info) != 0) {
+		return false;
+	}
+
+	for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+		if (info.texture_formats[i] == format) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Uploads 'surface' as 'options' say. Deallocates 'surface'.
+static spn_SDL_Texture *texture_with_options(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	SDL_Surface *surface,
+	const SPN_SDL_ImageOptions *options
+)
+{
+	if (options->format != SDL_PIXELFORMAT_UNKNOWN && renderer_supports_format(renderer, options->format)) {
+		format = options->format;
+	}
+
+	// fit in the maximal size
+	double scale = 1.0;
+	if (options->max_width > 0 && surface->w > options->max_width) {
+		scale = double(options->max_width) / surface->w;
+	}
+	if (options->max_height > 0 && surface->h * scale > options->max_height) {
+		scale = double(options->max_height) / surface->h;
+	}
+
+	int w = std::max(1, int(std::lround(surface->w * scale)));
+	int h = std::max(1, int(std::lround(surface->h * scale)));
+
+	if (scale == 1.0 && !options->mipmaps) {
+		return spnlib_SDL_texture_new_surface(renderer, surface, format);
+	}
+
+	// the resampler works on ARGB8888
+	if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+		SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(surface);
+		surface = converted;
+
+		if (surface == nullptr) {
+			return nullptr;
+		}
+	}
+
+	if (w != surface->w || h != surface->h) {
+		SDL_Surface *scaled = downscale(surface, w, h);
+		SDL_FreeSurface(surface);
+		surface = scaled;
+
+		if (surface == nullptr) {
+			return nullptr;
+		}
+	}
+
+	// each level is made from the previous one before it's uploaded
+	spn_SDL_Texture *texture = nullptr;
+	spn_SDL_Texture *last = nullptr;
+
+	while (surface) {
+		SDL_Surface *next = nullptr;
+
+		if (options->mipmaps && (surface->w > 1 || surface->h > 1)) {
+			next = downscale(surface, std::max(1, surface->w / 2), std::max(1, surface->h / 2));
+		}
+
+		spn_SDL_Texture *level = spnlib_SDL_texture_new_surface(renderer, surface, format);
+
+		if (last) {
+			last->mip = level;
+		} else {
+			texture = level;
+		}
+
+		last = level;
+		surface = next;
+	}
+
+	return texture;
+}
+
+static spn_SDL_Texture *load_image_uncached(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const char *filename,
+	const SPN_SDL_ImageOptions *options
+)
+{
+	SDL_Surface *surface = IMG_Load(filename);
+
+	if (surface == nullptr) {
+		return nullptr;
+	}
+
+	if (options) {
+		return texture_with_options(renderer, format, surface, options);
+	}
+
+	return spnlib_SDL_texture_new_surface(renderer, surface, format);
+}
+
+// Size of all mip levels of a texture in bytes
+static std::size_t texture_bytes(spn_SDL_Texture *texture)
+{
+	std::size_t bytes = 0;
+
+	for (; texture; texture = texture->mip) {
+		Uint32 format = 0;
+		int w = 0, h = 0;
+		SDL_QueryTexture(texture->texture, &format, nullptr, &w, &h);
+		bytes += std::size_t(w) * h * SDL_BYTESPERPIXEL(format);
+	}
+
+	return bytes;
+}
+
+// Resolves symbolic links and relative components, so that
+// different names of the same file share a cache entry
+static bool canonical_path(const char *filename, std::string *path, FileStamp *stamp)
+{
+	char *resolved = realpath(filename, nullptr);
+	if (resolved == nullptr) {
+		return false;
+	}
+
+	*path = resolved;
+	std::free(resolved);
+
+	struct stat st;
+	if (stat(path->c_str(), &st) != 0) {
+		return false;
+	}
+
+#ifdef __APPLE__
+	*stamp = { st.st_mtimespec, st.st_size };
+#else
+	*stamp = { st.st_mtim, st.st_size };
+#endif
+	return true;
+}
+
 spn_SDL_Texture *spnlib_sdl2_load_image(
 	SDL_Renderer *renderer,
+	Uint32 format,
 	const char *filename
 )
 {
-	SDL_Surface *surface = IMG_Load(filename);
+	return spnlib_sdl2_load_image_with_options(renderer, format, filename, nullptr);
+}
+
+spn_SDL_Texture *spnlib_sdl2_load_image_with_options(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const char *filename,
+	const SPN_SDL_ImageOptions *options
+)
+{
+	auto it = image_caches.find(renderer);
+	ImageCache *cache = it != image_caches.end() && it->second.textures.get_capacity() > 0
+	                  ? &it->second
+	                  : nullptr;
+
+	std::string path;
+	FileStamp stamp;
+
+	if (cache == nullptr || !canonical_path(filename, &path, &stamp)) {
+		return load_image_uncached(renderer, format, filename, options);
+	}
+
+	// the same file loaded with other options is another image
+	std::string key = path;
+	if (options) {
+		key += '\n' + std::to_string(options->max_width)
+		     + 'x' + std::to_string(options->max_height)
+		     + (options->mipmaps ? "m" : "")
+		     + '/' + std::to_string(options->format);
+	}
+
+	// the file changed since it was cached
+	auto old = cache->stamps.find(key);
+	if (old != cache->stamps.end() && !(old->second == stamp)) {
+		cache->textures.erase(key);
+		cache->stamps.erase(old);
+	}
+
+	spn_SDL_Texture *cached = cache->textures.lookup(key);
+	if (cached) {
+		spn_object_retain(cached);
+		return cached;
+	}
+
+	spn_SDL_Texture *texture = load_image_uncached(renderer, format, path.c_str(), options);
+
+	if (texture && texture->texture && cache->textures.insert(key, texture, texture_bytes(texture))) {
+		cache->stamps[key] = stamp;
+	}
+
+	return texture;
+}
+
+spn_SDL_Texture *spnlib_sdl2_load_image_from_memory(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const void *data,
+	size_t size,
+	const char *type
+)
+{
+	if (size > SDL_MAX_SINT32) {
+		return nullptr;
+	}
+
+	// the decoder reads 'data' in place; nothing is copied
+	SDL_RWops *rw = SDL_RWFromConstMem(data, int(size));
+	if (rw == nullptr) {
+		return nullptr;
+	}
+
+	SDL_Surface *surface = IMG_LoadTyped_RW(rw, 1, type);
 
 	if (surface == nullptr) {
 		return nullptr;
 	}
 
-	return spnlib_SDL_texture_new_surface(renderer, surface);
+	return spnlib_SDL_texture_new_surface(renderer, surface, format);
+}
+
+spn_SDL_Texture *spnlib_sdl2_load_image_mapped(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const char *filename
+)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		return nullptr;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return nullptr;
+	}
+
+	void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping stays valid
+
+	if (data == MAP_FAILED) {
+		return nullptr;
+	}
+
+	// IMG_Load() also passes the extension, which
+	// is needed for detecting formats such as TGA
+	const char *ext = std::strrchr(filename, '.');
+
+	spn_SDL_Texture *texture = spnlib_sdl2_load_image_from_memory(
+		renderer,
+		format,
+		data,
+		st.st_size,
+		ext ? ext + 1 : nullptr
+	);
+
+	munmap(data, st.st_size);
+
+	return texture;
+}
+
+void spnlib_sdl2_image_cache_set_capacity(SDL_Renderer *renderer, size_t bytes)
+{
+	image_caches[renderer].textures.set_capacity(bytes);
+}
+
+void spnlib_sdl2_image_cache_purge(SDL_Renderer *renderer)
+{
+	auto it = image_caches.find(renderer);
+	if (it != image_caches.end()) {
+		it->second.textures.purge();
+	}
+}
+
+SPN_SDL_ImageCacheStats spnlib_sdl2_image_cache_stats(SDL_Renderer *renderer)
+{
+	SPN_SDL_ImageCacheStats stats = { 0, 0, 0, 0, 0 };
+
+	auto it = image_caches.find(renderer);
+	if (it != image_caches.end()) {
+		const ImageCache &cache = it->second;
+		stats.hits = cache.textures.get_hits();
+		stats.misses = cache.textures.get_misses();
+		stats.bytes = cache.textures.get_size();
+		stats.count = cache.textures.get_count();
+		stats.capacity = cache.textures.get_capacity();
+	}
+
+	return stats;
+}
+
+void spnlib_sdl2_image_release_renderer(SDL_Renderer *renderer)
+{
+	image_caches.erase(renderer);
+}
+
+SDL_Surface *spnlib_sdl2_decode_image(const char *filename, Uint32 format)
+{
+	SDL_Surface *surface = IMG_Load(filename);
+
+	if (surface && surface->format->format != format) {
+		SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+		SDL_FreeSurface(surface);
+		surface = converted;
+	}
+
+	return surface;
+}
+
+// Decodes images on background threads, which are started on first use.
+// Only decoding and pixel format conversion happen on these threads;
+// textures are created when the main thread receives the event.
+class ImageLoader {
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	std::deque<SPN_SDL_ImageLoad *> queue;
+	std::vector<SPN_SDL_ImageLoad *> abandoned; // decoded, but never delivered
+	std::vector<std::thread> workers;
+	bool stopping;
+
+	static const unsigned max_workers = 4;
+
+	void work()
+	{
+		while (true) {
+			SPN_SDL_ImageLoad *load;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wakeup.wait(lock, [this] { return stopping || !queue.empty(); });
+
+				if (stopping) {
+					return;
+				}
+
+				load = queue.front();
+				queue.pop_front();
+			}
+
+			load->surface = spnlib_sdl2_decode_image(load->filename, load->format);
+
+			SDL_Event event;
+			SDL_zero(event);
+			event.type = SDL_USEREVENT;
+			event.user.code = SPN_SDL_USEREVENT_IMAGE_LOADED;
+			event.user.data1 = load;
+
+			// the event queue may be full; the load must not get lost,
+			// since only the main thread may release its owner. Once
+			// stopping, the queue may be gone for good (after SDL_Quit()),
+			// so the load is left to shutdown() instead.
+			while (SDL_PushEvent(&event) < 0) {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+
+					if (stopping) {
+						abandoned.push_back(load);
+						break;
+					}
+				}
+
+				SDL_Delay(1);
+			}
+		}
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		wakeup.notify_all();
+
+		for (std::thread &worker : workers) {
+			worker.join();
+		}
+
+		workers.clear();
+		stopping = false;
+	}
+
+public:
+	ImageLoader() : stopping(false) {}
+
+	ImageLoader(const ImageLoader &) = delete;
+	ImageLoader &operator=(const ImageLoader &) = delete;
+
+	~ImageLoader()
+	{
+		stop();
+	}
+
+	// Joins the workers, then frees the loads that were not delivered.
+	// Must be called on the main thread, since it releases their owners.
+	// Workers are started again by the next enqueue().
+	void shutdown()
+	{
+		stop();
+
+		for (SPN_SDL_ImageLoad *load : queue) {
+			spnlib_sdl2_cancel_image_load(load);
+		}
+
+		for (SPN_SDL_ImageLoad *load : abandoned) {
+			spnlib_sdl2_cancel_image_load(load);
+		}
+
+		queue.clear();
+		abandoned.clear();
+	}
+
+	void enqueue(SPN_SDL_ImageLoad *load)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(load);
+
+			if (workers.empty()) {
+				// leave a core to the main thread
+				unsigned cores = std::thread::hardware_concurrency();
+				unsigned n = cores > 1 ? cores - 1 : 1;
+				if (n > max_workers) {
+					n = max_workers;
+				}
+
+				for (unsigned i = 0; i < n; i++) {
+					workers.emplace_back(&ImageLoader::work, this);
+				}
+			}
+		}
+
+		wakeup.notify_one();
+	}
+};
+
+// destroyed (and its threads joined) before IMG_Quit() is called
+static ImageLoader image_loader;
+
+Uint32 spnlib_sdl2_load_image_async(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const char *filename,
+	SpnObject *owner
+)
+{
+	static Uint32 next_id = 1;
+
+	Uint32 id = next_id++;
+	if (next_id == 0) {
+		next_id = 1;
+	}
+
+	SPN_SDL_ImageLoad *load = new SPN_SDL_ImageLoad;
+	load->id = id;
+	load->filename = SDL_strdup(filename);
+	load->renderer = renderer;
+	load->format = format;
+	load->owner = owner;
+	load->surface = nullptr;
+
+	spn_object_retain(owner);
+	image_loader.enqueue(load);
+
+	return id;
+}
+
+spn_SDL_Texture *spnlib_sdl2_finish_image_load(SPN_SDL_ImageLoad *load)
+{
+	spn_SDL_Texture *texture = nullptr;
+
+	if (load->surface) {
+		texture = spnlib_SDL_texture_new_surface(load->renderer, load->surface, load->format);
+	}
+
+	spn_object_release(load->owner);
+	SDL_free(load->filename);
+	delete load;
+
+	return texture;
+}
+
+void spnlib_sdl2_cancel_image_load(SPN_SDL_ImageLoad *load)
+{
+	SDL_FreeSurface(load->surface);
+	spn_object_release(load->owner);
+	SDL_free(load->filename);
+	delete load;
+}
+
+void spnlib_sdl2_image_loader_quit(void)
+{
+	image_loader.shutdown();
 }
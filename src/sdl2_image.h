@@ -11,13 +11,129 @@
 #ifndef SPNLIB_SDL2_IMAGE_H
 #define SPNLIB_SDL2_IMAGE_H
 
+#include <stdbool.h>
+
 #include <spn/api.h>
 
 #include "sdl2_texture.h"
 
+// 'format' is the texture format to convert the image to
+// (see spnlib_SDL_preferred_texture_format())
+// While the image cache of 'renderer' is enabled, loading the same file
+// again returns a new reference to the same texture object, unless the
+// file has been modified since.
 SPN_API spn_SDL_Texture *spnlib_sdl2_load_image(
 	SDL_Renderer *renderer,
+	Uint32 format,
+	const char *filename
+);
+
+typedef struct SPN_SDL_ImageOptions {
+	// The image is downscaled (keeping its aspect ratio) to fit in
+	// max_width * max_height; 0 means no limit
+	int max_width, max_height;
+
+	// also create the image at half size, quarter size, etc. down to
+	// 1 * 1 pixel, linked from the 'mip' member of the texture
+	bool mipmaps;
+
+	// SDL_PIXELFORMAT_RGB565 or SDL_PIXELFORMAT_ARGB4444 for textures
+	// with 16 bits per pixel, or SDL_PIXELFORMAT_UNKNOWN (0) for the
+	// default format. Ignored if the renderer doesn't support it natively.
+	Uint32 format;
+} SPN_SDL_ImageOptions;
+
+// Same as spnlib_sdl2_load_image(), but the image is processed as
+// 'options' say. Images loaded with different options are cached
+// separately.
+SPN_API spn_SDL_Texture *spnlib_sdl2_load_image_with_options(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const char *filename,
+	const SPN_SDL_ImageOptions *options
+);
+
+// Decodes an image from 'size' bytes at 'data' (which are not copied).
+// 'type' is the file extension naming the format, e. g. "png"; NULL
+// means that the format is detected from the data, which works for
+// every format except TGA.
+SPN_API spn_SDL_Texture *spnlib_sdl2_load_image_from_memory(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const void *data,
+	size_t size,
+	const char *type
+);
+
+// Same as spnlib_sdl2_load_image(), but the file is memory-mapped and
+// decoded from the mapping, instead of being read into buffers first.
+// Images loaded this way are not cached.
+SPN_API spn_SDL_Texture *spnlib_sdl2_load_image_mapped(
+	SDL_Renderer *renderer,
+	Uint32 format,
 	const char *filename
 );
 
+typedef struct SPN_SDL_ImageCacheStats {
+	unsigned long hits;
+	unsigned long misses;
+	size_t bytes; // total size of the cached textures
+	size_t count; // number of cached textures
+	size_t capacity;
+} SPN_SDL_ImageCacheStats;
+
+// Sets the maximal total size (in bytes) of the cached images of
+// 'renderer'. Files are identified by their canonical path, and their
+// modification time is checked on each load. 0 (the default) disables
+// caching. Least recently loaded images are dropped first.
+SPN_API void spnlib_sdl2_image_cache_set_capacity(SDL_Renderer *renderer, size_t bytes);
+
+// Drops every cached image of 'renderer'
+SPN_API void spnlib_sdl2_image_cache_purge(SDL_Renderer *renderer);
+
+SPN_API SPN_SDL_ImageCacheStats spnlib_sdl2_image_cache_stats(SDL_Renderer *renderer);
+
+// Must be called before 'renderer' is destroyed
+SPN_API void spnlib_sdl2_image_release_renderer(SDL_Renderer *renderer);
+
+// Decodes 'filename' into a surface of 'format' without creating a
+// texture, so it can be used from any thread. Returns NULL on error.
+SPN_API SDL_Surface *spnlib_sdl2_decode_image(const char *filename, Uint32 format);
+
+// An image decoded by a background thread, delivered as 'data1' of an
+// SDL_USEREVENT with code SPN_SDL_USEREVENT_IMAGE_LOADED
+typedef struct SPN_SDL_ImageLoad {
+	Uint32 id; // as returned by spnlib_sdl2_load_image_async()
+	char *filename;
+	SDL_Renderer *renderer;
+	Uint32 format;
+	SpnObject *owner; // retained until the load is finished
+	SDL_Surface *surface; // already in 'format'; NULL if decoding failed
+} SPN_SDL_ImageLoad;
+
+// Decodes 'filename' on one of a few background threads, then pushes an
+// event to the queue of the main thread. The texture is only created
+// by spnlib_sdl2_finish_image_load(), since renderers are not thread
+// safe. 'owner' (e. g. the window owning 'renderer') is kept alive in
+// the meantime. Returns a nonzero ID identifying the request.
+SPN_API Uint32 spnlib_sdl2_load_image_async(
+	SDL_Renderer *renderer,
+	Uint32 format,
+	const char *filename,
+	SpnObject *owner
+);
+
+// Uploads the decoded image into a texture, then frees 'load'. Must
+// be called on the thread that renders. Returns NULL if the image
+// couldn't be loaded.
+SPN_API spn_SDL_Texture *spnlib_sdl2_finish_image_load(SPN_SDL_ImageLoad *load);
+
+// Frees 'load' without creating a texture. Must be called on the main
+// thread, like spnlib_sdl2_finish_image_load().
+SPN_API void spnlib_sdl2_cancel_image_load(SPN_SDL_ImageLoad *load);
+
+// Stops and joins the background threads, and cancels the loads that
+// haven't been delivered yet; called before SDL is deinitialized
+SPN_API void spnlib_sdl2_image_loader_quit(void);
+
 #endif // SPNLIB_SDL2_IMAGE_H
@@ -0,0 +1,444 @@
+//
+// sdl2_label.c
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#include <string.h>
+
+#include "sdl2_label.h"
+#include "sdl2_sparkling.h"
+#include "sdl2_window.h"
+#include "sdl2_texture.h"
+#include "sdl2_ttf.h"
+#include "helpers.h"
+
+/////////////////////////////////
+//   TextLabel Class structure //
+/////////////////////////////////
+
+// A label keeps the texture of its text until one of its properties
+// changes, so that static text is only rendered once. Textures of all
+// labels share a memory budget; when it is exceeded, the textures of
+// the least recently drawn labels are freed, and re-rendered on demand.
+typedef struct spn_SDL_TextLabel {
+	SpnObject base;
+	spn_SDL_Window *window; // retained, since the texture belongs to its renderer
+	SpnString *text; // retained
+	TTF_Font *font;
+	int style; // the font is shared, so its style is only set while rendering
+	SDL_Color color; // applied by color and alpha modulation
+	bool hq;
+
+	spn_SDL_Texture *texture; // NULL if not rendered (or evicted)
+	size_t bytes; // size of 'texture'
+	bool dirty; // needs to be rendered before drawing
+
+	// links of the list of labels owning a texture,
+	// most recently drawn first
+	struct spn_SDL_TextLabel *prev, *next;
+} spn_SDL_TextLabel;
+
+static spn_SDL_TextLabel *lru_head = NULL;
+static spn_SDL_TextLabel *lru_tail = NULL;
+
+static size_t label_bytes = 0;
+static size_t label_capacity = 32 * 1024 * 1024;
+
+static void lru_unlink(spn_SDL_TextLabel *label)
+{
+	if (label->prev) {
+		label->prev->next = label->next;
+	} else if (lru_head == label) {
+		lru_head = label->next;
+	}
+
+	if (label->next) {
+		label->next->prev = label->prev;
+	} else if (lru_tail == label) {
+		lru_tail = label->prev;
+	}
+
+	label->prev = label->next = NULL;
+}
+
+static void lru_push_front(spn_SDL_TextLabel *label)
+{
+	label->prev = NULL;
+	label->next = lru_head;
+
+	if (lru_head) {
+		lru_head->prev = label;
+	} else {
+		lru_tail = label;
+	}
+
+	lru_head = label;
+}
+
+// Frees the texture; the label will be re-rendered when next drawn
+static void label_release_texture(spn_SDL_TextLabel *label)
+{
+	if (label->texture) {
+		lru_unlink(label);
+		label_bytes -= label->bytes;
+		spn_object_release(label->texture);
+		label->texture = NULL;
+		label->bytes = 0;
+	}
+
+	label->dirty = true;
+}
+
+// Frees textures of the least recently drawn labels, except
+// 'keep', until their total size fits into the budget
+static void label_evict(spn_SDL_TextLabel *keep)
+{
+	spn_SDL_TextLabel *victim = lru_tail;
+
+	while (label_bytes > label_capacity && victim) {
+		spn_SDL_TextLabel *prev = victim->prev;
+
+		if (victim != keep) {
+			label_release_texture(victim);
+		}
+
+		victim = prev;
+	}
+}
+
+// Renders the text of the label if needed
+static void label_update(spn_SDL_TextLabel *label)
+{
+	if (!label->dirty) {
+		// mark as most recently used
+		if (label->texture && lru_head != label) {
+			lru_unlink(label);
+			lru_push_front(label);
+		}
+
+		return;
+	}
+
+	label_release_texture(label);
+	label->dirty = false;
+
+	int saved_style = TTF_GetFontStyle(label->font);
+	if (saved_style != label->style) {
+		TTF_SetFontStyle(label->font, label->style);
+	}
+
+	// rendered in white, so that the color can be changed
+	// without rendering again, by color modulation
+	SDL_Color white = { 255, 255, 255, 255 };
+	SDL_Surface *surface = label->hq
+	                     ? TTF_RenderUTF8_Blended(label->font, label->text->cstr, white)
+	                     : TTF_RenderUTF8_Solid(label->font, label->text->cstr, white);
+
+	if (saved_style != label->style) {
+		TTF_SetFontStyle(label->font, saved_style);
+	}
+
+	spn_SDL_Window *window = label->window;
+	spn_SDL_Texture *texture = spnlib_SDL_texture_new_surface(window->renderer, surface, window->format);
+
+	// e. g. empty text: there's nothing to draw
+	if (texture->texture == NULL) {
+		spn_object_release(texture);
+		return;
+	}
+
+	label->texture = texture;
+	label->bytes = (size_t)texture->width * texture->height * SDL_BYTESPERPIXEL(window->format);
+	label_bytes += label->bytes;
+
+	lru_push_front(label);
+	label_evict(label);
+}
+
+static void spn_SDL_TextLabel_dtor(void *o)
+{
+	spn_SDL_TextLabel *label = o;
+
+	label_release_texture(label);
+	spn_object_release(label->text);
+	spn_object_release(label->window);
+}
+
+static const SpnClass spn_SDL_TextLabel_class = {
+	sizeof(spn_SDL_TextLabel),
+	SPN_SDL_CLASS_UID_LABEL,
+	NULL,
+	NULL,
+	NULL,
+	spn_SDL_TextLabel_dtor
+};
+
+static spn_SDL_TextLabel *label_from_hashmap(SpnHashMap *hm)
+{
+	SpnValue objv = spn_hashmap_get_strkey(hm, "label");
+
+	if (!spn_isstrguserinfo(&objv)) {
+		return NULL;
+	}
+
+	spn_SDL_TextLabel *label = spn_objvalue(&objv);
+
+	if (!spn_object_member_of_class(label, &spn_SDL_TextLabel_class)) {
+		return NULL;
+	}
+
+	return label;
+}
+
+#define CHECK_FOR_LABEL_HASHMAP(argnum)                                \
+	CHECK_ARG_RETURN_ON_ERROR(argnum, hashmap);                        \
+	spn_SDL_TextLabel *label = label_from_hashmap(HASHMAPARG(argnum)); \
+	if (label == NULL) {                                               \
+		spn_ctx_runtime_error(ctx, "label object is invalid", NULL);   \
+		return -1;                                                     \
+	}
+
+/////////////////////////////////
+//  Initialize TextLabel Class //
+/////////////////////////////////
+
+// Creates a label showing 'text' using the current font
+// and drawing color of the window.
+// Parameters:
+// 0. the window object
+// 1. the text of the label, as a string
+// 2. (optional) boolean, false: fast, true: high-quality (default)
+int spnlib_SDL_Window_createLabel(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	spn_SDL_Window *window = window_from_hashmap(HASHMAPARG(0));
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	if (window->font == NULL) {
+		const char *msg = window->bitmap_font
+		                ? "labels need a TrueType font, not a bitmap font"
+		                : "no font set; call setFont() first";
+		spn_ctx_runtime_error(ctx, msg, NULL);
+		return -2;
+	}
+
+	bool hq = true;
+	if (argc > 2) {
+		CHECK_ARG_RETURN_ON_ERROR(2, bool);
+		hq = BOOLARG(2);
+	}
+
+	spn_SDL_TextLabel *label = spn_object_new(&spn_SDL_TextLabel_class);
+
+	spn_object_retain(window);
+	label->window = window;
+
+	label->text = spn_stringvalue(&argv[1]);
+	spn_object_retain(label->text);
+
+	label->font = window->font;
+	label->style = TTF_GetFontStyle(window->font);
+	SDL_GetRenderDrawColor(
+		window->renderer,
+		&label->color.r,
+		&label->color.g,
+		&label->color.b,
+		&label->color.a
+	);
+	label->hq = hq;
+
+	label->texture = NULL;
+	label->bytes = 0;
+	label->dirty = true;
+	label->prev = label->next = NULL;
+
+	// construct return value
+	*ret = spn_makehashmap();
+	SpnHashMap *hm = spn_hashmapvalue(ret);
+
+	// set its prototype
+	SpnValue proto = spn_get_lib_prototype("TextLabel");
+	spn_hashmap_set_strkey(hm, "super", &proto);
+
+	SpnValue labelval = spn_makestrguserinfo(label);
+	spn_hashmap_set_strkey(hm, "label", &labelval);
+	spn_value_release(&labelval);
+
+	return 0;
+}
+
+// Parameters:
+// 0. maximal total size of label textures in bytes
+int spnlib_SDL_SetLabelCacheSize(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, number);
+
+	double bytes = NUMARG(0);
+	label_capacity = bytes > 0 ? bytes : 0;
+	label_evict(NULL);
+
+	return 0;
+}
+
+void spnlib_SDL_label_release_textures(void)
+{
+	while (lru_head) {
+		label_release_texture(lru_head);
+	}
+}
+
+/////////////////////////////////
+//      TextLabel methods      //
+/////////////////////////////////
+
+// Parameters:
+// 0. the label object
+// 1. the new text, as a string
+static int spnlib_SDL_TextLabel_setText(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_LABEL_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	SpnString *text = spn_stringvalue(&argv[1]);
+
+	if (text == label->text || strcmp(text->cstr, label->text->cstr) == 0) {
+		return 0;
+	}
+
+	spn_object_retain(text);
+	spn_object_release(label->text);
+	label->text = text;
+
+	label_release_texture(label);
+
+	return 0;
+}
+
+static int spnlib_SDL_TextLabel_getText(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_LABEL_HASHMAP(0);
+
+	spn_object_retain(label->text);
+	*ret = (SpnValue){ .type = SPN_TYPE_STRING, .v.o = label->text };
+
+	return 0;
+}
+
+// Same parameters as Window.setFont()
+static int spnlib_SDL_TextLabel_setFont(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_LABEL_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+	CHECK_ARG_RETURN_ON_ERROR(3, string);
+
+	// the style of the shared font is only set while rendering
+	int style;
+	TTF_Font *font = spnlib_sdl2_get_font_unstyled(STRARG(1), NUMARG(2), STRARG(3), &style);
+
+	if (font == NULL) {
+		spn_ctx_runtime_error(ctx, "cannot open font", NULL);
+		return -2;
+	}
+
+	if (font != label->font || style != label->style) {
+		label->font = font;
+		label->style = style;
+		label_release_texture(label);
+	}
+
+	return 0;
+}
+
+// Same parameters as Window.setColor()
+static int spnlib_SDL_TextLabel_setColor(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_LABEL_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+	CHECK_ARG_RETURN_ON_ERROR(3, number);
+	CHECK_ARG_RETURN_ON_ERROR(4, number);
+
+	SDL_Color color = {
+		constrain_to_01(NUMARG(1)) * 255,
+		constrain_to_01(NUMARG(2)) * 255,
+		constrain_to_01(NUMARG(3)) * 255,
+		constrain_to_01(NUMARG(4)) * 255
+	};
+
+	// the texture is tinted when drawn, so it doesn't need rendering again
+	label->color = color;
+
+	return 0;
+}
+
+// Returns a hashmap with keys "width" and "height"
+static int spnlib_SDL_TextLabel_size(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_LABEL_HASHMAP(0);
+
+	label_update(label);
+
+	*ret = spn_makehashmap();
+	SpnHashMap *size = spn_hashmapvalue(ret);
+
+	set_integer_property(size, "width", label->texture ? label->texture->width : 0);
+	set_integer_property(size, "height", label->texture ? label->texture->height : 0);
+
+	return 0;
+}
+
+// Draws the label in its window, rendering its text first if needed.
+// Parameters:
+// 0. the label object
+// 1. X coordinate of the top left corner
+// 2. Y coordinate of the top left corner
+static int spnlib_SDL_TextLabel_draw(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_LABEL_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+
+	label_update(label);
+
+	if (label->texture) {
+		spn_SDL_Texture *texture = label->texture;
+		SDL_Color color = label->color;
+		SDL_SetTextureColorMod(texture->texture, color.r, color.g, color.b);
+		SDL_SetTextureAlphaMod(texture->texture, color.a);
+
+		SDL_Rect dst = { NUMARG(1), NUMARG(2), texture->width, texture->height };
+		SDL_RenderCopy(label->window->renderer, texture->texture, NULL, &dst);
+	}
+
+	return 0;
+}
+
+/////////////////////////////////
+//  TextLabel methods creation //
+/////////////////////////////////
+void spnlib_SDL_methods_for_TextLabel(SpnHashMap *label)
+{
+	static const SpnExtFunc methods[] = {
+		{ "setText",  spnlib_SDL_TextLabel_setText  },
+		{ "getText",  spnlib_SDL_TextLabel_getText  },
+		{ "setFont",  spnlib_SDL_TextLabel_setFont  },
+		{ "setColor", spnlib_SDL_TextLabel_setColor },
+		{ "size",     spnlib_SDL_TextLabel_size     },
+		{ "draw",     spnlib_SDL_TextLabel_draw     }
+	};
+
+	for (size_t i = 0; i < COUNT(methods); i++) {
+		SpnValue fnval = spn_makenativefunc(methods[i].name, methods[i].fn);
+		spn_hashmap_set_strkey(label, methods[i].name, &fnval);
+		spn_value_release(&fnval);
+	}
+}
@@ -0,0 +1,28 @@
+//
+// sdl2_label.h
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#ifndef SPNLIB_SDL2_LABEL_H
+#define SPNLIB_SDL2_LABEL_H
+
+#include <spn/ctx.h>
+#include <spn/api.h>
+
+#include <SDL2/SDL.h>
+
+// Window.createLabel(); argument #0 is the window object
+int spnlib_SDL_Window_createLabel(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+
+// Sets the maximal total size (in bytes) of the textures of all labels
+int spnlib_SDL_SetLabelCacheSize(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+
+// Frees the texture of every label. They are re-rendered when next drawn.
+void spnlib_SDL_label_release_textures(void);
+
+// In order to bridge data between sdl2_sparkling.c and this file
+void spnlib_SDL_methods_for_TextLabel(SpnHashMap *label);
+
+#endif // SPNLIB_SDL2_LABEL_H
@@ -0,0 +1,318 @@
+//
+// sdl2_record.c
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#include <string.h>
+
+#include "sdl2_record.h"
+#include "sdl2_sparkling.h"
+#include "sdl2_event.h"
+
+//
+// Recording
+//
+
+// Guards the state of the recording, since events
+// are watched on the thread that pushes them
+static SDL_mutex *record_mutex = NULL;
+static SDL_RWops *record_file = NULL;
+static Uint32 record_start;
+static bool record_failed;
+
+// Events referring to memory (user events, dropped files and window
+// manager messages) or to the state of the application rather than
+// to its input (lifecycle and render device events) are not recorded
+static bool is_recordable(const SDL_Event *event)
+{
+	switch (event->type) {
+	case SDL_SYSWMEVENT:
+	case SDL_DROPFILE:
+#if SDL_VERSION_ATLEAST(2, 0, 5)
+	case SDL_DROPTEXT:
+#endif
+	case SDL_RENDER_TARGETS_RESET:
+	case SDL_RENDER_DEVICE_RESET:
+		return false;
+	default:
+		break;
+	}
+
+	// application lifecycle events lie between these two
+	if (event->type > SDL_QUIT && event->type < SDL_WINDOWEVENT) {
+		return false;
+	}
+
+	return event->type < SDL_USEREVENT;
+}
+
+static int record_event(void *userdata, SDL_Event *event)
+{
+	if (!is_recordable(event)) {
+		return 0;
+	}
+
+	SDL_LockMutex(record_mutex);
+
+	if (record_file) {
+		// the timestamp is set by SDL_PushEvent() before calling watches
+		Sint32 elapsed = event->common.timestamp - record_start;
+		Uint32 time = elapsed > 0 ? elapsed : 0;
+
+		if (SDL_RWwrite(record_file, &time, sizeof time, 1) != 1
+		 || SDL_RWwrite(record_file, event, sizeof *event, 1) != 1) {
+			record_failed = true;
+		}
+	}
+
+	SDL_UnlockMutex(record_mutex);
+	return 0;
+}
+
+// Starts writing every input event into a log file.
+// Parameters:
+// 0. name of the log file; it is overwritten if it exists
+// Returns false if the file can't be created.
+int spnlib_SDL_StartEventRecording(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, string);
+
+	if (record_mutex == NULL) {
+		record_mutex = SDL_CreateMutex();
+	}
+
+	if (record_file) {
+		spn_ctx_runtime_error(ctx, "events are already being recorded", NULL);
+		return -1;
+	}
+
+	SDL_RWops *file = SDL_RWFromFile(STRARG(0), "wb");
+	if (file == NULL) {
+		*ret = spn_makebool(false);
+		return 0;
+	}
+
+	SPN_SDL_EventLogHeader header;
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, SPN_SDL_EVENT_LOG_MAGIC, sizeof header.magic);
+	header.version = SPN_SDL_EVENT_LOG_VERSION;
+	header.event_size = sizeof(SDL_Event);
+
+	if (SDL_RWwrite(file, &header, sizeof header, 1) != 1) {
+		SDL_RWclose(file);
+		*ret = spn_makebool(false);
+		return 0;
+	}
+
+	SDL_LockMutex(record_mutex);
+	record_file = file;
+	record_start = SDL_GetTicks();
+	record_failed = false;
+	SDL_UnlockMutex(record_mutex);
+
+	SDL_AddEventWatch(record_event, NULL);
+
+	*ret = spn_makebool(true);
+	return 0;
+}
+
+static bool stop_recording(void)
+{
+	if (record_file == NULL) {
+		return false;
+	}
+
+	SDL_DelEventWatch(record_event, NULL);
+
+	SDL_LockMutex(record_mutex);
+	bool success = SDL_RWclose(record_file) == 0 && !record_failed;
+	record_file = NULL;
+	SDL_UnlockMutex(record_mutex);
+
+	return success;
+}
+
+// Stops recording and closes the log file.
+// Returns false if the log couldn't be written completely.
+int spnlib_SDL_StopEventRecording(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	*ret = spn_makebool(stop_recording());
+	return 0;
+}
+
+//
+// Replaying
+//
+
+typedef struct EventReplay {
+	SDL_RWops *file; // positioned after the header
+	double speed; // 0 means no delays
+	SDL_mutex *mutex;
+	SDL_cond *cond; // signaled when 'stop' is set
+	bool stop;
+} EventReplay;
+
+static EventReplay *replay = NULL;
+static SDL_Thread *replay_thread = NULL;
+
+// Pushes the events of the log, each after the time it was recorded
+// at (divided by the speed) has elapsed since the replay started
+static int replay_events(void *data)
+{
+	EventReplay *state = data;
+	Uint32 start = SDL_GetTicks();
+	Uint32 time;
+	SDL_Event event;
+
+	while (SDL_RWread(state->file, &time, sizeof time, 1) == 1
+	    && SDL_RWread(state->file, &event, sizeof event, 1) == 1) {
+		Uint32 due = start + (state->speed > 0 ? (Uint32)(time / state->speed) : 0);
+
+		SDL_LockMutex(state->mutex);
+
+		for (;;) {
+			Sint32 wait = due - SDL_GetTicks();
+
+			if (state->stop || wait <= 0) {
+				break;
+			}
+
+			SDL_CondWaitTimeout(state->cond, state->mutex, wait);
+		}
+
+		bool stop = state->stop;
+		SDL_UnlockMutex(state->mutex);
+
+		if (stop) {
+			return 0;
+		}
+
+		// the queue is full; wait for the main thread to drain it
+		while (SDL_PushEvent(&event) < 0) {
+			SDL_LockMutex(state->mutex);
+
+			if (!state->stop) {
+				SDL_CondWaitTimeout(state->cond, state->mutex, 1);
+			}
+
+			stop = state->stop;
+			SDL_UnlockMutex(state->mutex);
+
+			if (stop) {
+				return 0;
+			}
+		}
+	}
+
+	SDL_zero(event);
+	event.type = SDL_USEREVENT;
+	event.user.code = SPN_SDL_USEREVENT_REPLAY_FINISHED;
+	SDL_PushEvent(&event);
+
+	return 0;
+}
+
+static void stop_replay(void)
+{
+	if (replay == NULL) {
+		return;
+	}
+
+	SDL_LockMutex(replay->mutex);
+	replay->stop = true;
+	SDL_CondSignal(replay->cond);
+	SDL_UnlockMutex(replay->mutex);
+
+	SDL_WaitThread(replay_thread, NULL);
+
+	SDL_RWclose(replay->file);
+	SDL_DestroyCond(replay->cond);
+	SDL_DestroyMutex(replay->mutex);
+	SDL_free(replay);
+
+	replay = NULL;
+	replay_thread = NULL;
+}
+
+// Pushes the events of a log written by StartEventRecording() into the
+// event queue from a background thread, with their original timing.
+// A "replayfinished" event is pushed after the last one.
+// Parameters:
+// 0. name of the log file
+// 1. (optional) speed factor: 2 replays twice as fast, 0 replays
+//    without delays (default: 1)
+// Returns false if the file can't be opened or isn't a valid log.
+int spnlib_SDL_StartEventReplay(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, string);
+
+	double speed = 1;
+
+	if (argc > 1) {
+		CHECK_ARG_RETURN_ON_ERROR(1, number);
+		speed = NUMARG(1);
+
+		if (speed < 0) {
+			spn_ctx_runtime_error(ctx, "speed must not be negative", NULL);
+			return -2;
+		}
+	}
+
+	// stop the replay in progress, or clean up a finished one
+	stop_replay();
+
+	SDL_RWops *file = SDL_RWFromFile(STRARG(0), "rb");
+	if (file == NULL) {
+		*ret = spn_makebool(false);
+		return 0;
+	}
+
+	SPN_SDL_EventLogHeader header;
+
+	if (SDL_RWread(file, &header, sizeof header, 1) != 1
+	 || memcmp(header.magic, SPN_SDL_EVENT_LOG_MAGIC, sizeof header.magic) != 0
+	 || header.version != SPN_SDL_EVENT_LOG_VERSION
+	 || header.event_size != sizeof(SDL_Event)) {
+		SDL_RWclose(file);
+		*ret = spn_makebool(false);
+		return 0;
+	}
+
+	replay = SDL_malloc(sizeof *replay);
+	replay->file = file;
+	replay->speed = speed;
+	replay->mutex = SDL_CreateMutex();
+	replay->cond = SDL_CreateCond();
+	replay->stop = false;
+
+	replay_thread = SDL_CreateThread(replay_events, "spn-event-replay", replay);
+
+	if (replay_thread == NULL) {
+		SDL_RWclose(file);
+		SDL_DestroyCond(replay->cond);
+		SDL_DestroyMutex(replay->mutex);
+		SDL_free(replay);
+		replay = NULL;
+
+		*ret = spn_makebool(false);
+		return 0;
+	}
+
+	*ret = spn_makebool(true);
+	return 0;
+}
+
+// Stops the replay; events already pushed stay in the queue
+int spnlib_SDL_StopEventReplay(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	stop_replay();
+	return 0;
+}
+
+void spnlib_SDL_record_quit(void)
+{
+	stop_replay();
+	stop_recording();
+}
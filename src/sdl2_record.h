@@ -0,0 +1,37 @@
+//
+// sdl2_record.h
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#ifndef SPNLIB_SDL2_RECORD_H
+#define SPNLIB_SDL2_RECORD_H
+
+#include <spn/ctx.h>
+#include <spn/api.h>
+
+#include <SDL2/SDL.h>
+
+// An event log consists of a SPN_SDL_EventLogHeader followed by records
+// of a Uint32 (milliseconds since the recording started) and the raw
+// SDL_Event ('event_size' bytes). Integers are in native byte order:
+// logs are meant to be replayed by the same build that recorded them.
+#define SPN_SDL_EVENT_LOG_MAGIC   "SPNEVLOG"
+#define SPN_SDL_EVENT_LOG_VERSION 1
+
+typedef struct SPN_SDL_EventLogHeader {
+	char magic[8]; // SPN_SDL_EVENT_LOG_MAGIC, without the NUL
+	Uint32 version;
+	Uint32 event_size; // sizeof(SDL_Event)
+} SPN_SDL_EventLogHeader;
+
+int spnlib_SDL_StartEventRecording(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+int spnlib_SDL_StopEventRecording(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+int spnlib_SDL_StartEventReplay(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+int spnlib_SDL_StopEventReplay(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+
+// Stops recording and replaying; called before SDL is deinitialized
+void spnlib_SDL_record_quit(void);
+
+#endif // SPNLIB_SDL2_RECORD_H
@@ -18,6 +18,13 @@
 #include "sdl2_timer.h"
 #include "sdl2_extras.h"
 #include "sdl2_audio.h"
+#include "sdl2_label.h"
+#include "sdl2_console.h"
+#include "sdl2_tiled.h"
+#include "sdl2_record.h"
+#include "sdl2_image.h"
+#include "sdl2_gradient.h"
+#include "sdl2_assetpack.h"
 
 
 /////////////////////////////////
@@ -59,23 +66,33 @@ static void spn_SDL_construct_library(void)
 
 	// top-level library functions
 	static const SpnExtFunc fns[] = {
-		{ "OpenWindow",   spnlib_SDL_OpenWindow   },
-		{ "PollEvent",    spnlib_SDL_PollEvent    },
-		{ "StartTimer",   spnlib_SDL_StartTimer   },
-		{ "StopTimer",    spnlib_SDL_StopTimer    },
-		{ "OpenMusic",    spnlib_SDL_OpenMusic    },
-		{ "OpenSample",   spnlib_SDL_OpenSample   },
-		{ "OpenChannels", spnlib_SDL_OpenChannels },
-		{ "GetError",     spnlib_SDL_GetError     },
-		{ "SetError",     spnlib_SDL_SetError     },
-		{ "GetMixError",  spnlib_SDL_GetMixError  },
-		{ "SetMixError",  spnlib_SDL_SetMixError  },
-		{ "GetPaths",     spnlib_SDL_GetPaths     },
-		{ "GetVersions",  spnlib_SDL_GetVersions  },
-		{ "GetPlatform",  spnlib_SDL_GetPlatform  },
-		{ "GetCPUSpecs",  spnlib_SDL_GetCPUSpecs  },
-		{ "GetPowerInfo", spnlib_SDL_GetPowerInfo },
-		{ "Delay",        spnlib_SDL_Delay        }
+		{ "OpenWindow",          spnlib_SDL_OpenWindow          },
+		{ "CreateGradient",      spnlib_SDL_CreateGradient      },
+		{ "OpenAssetPack",       spnlib_SDL_OpenAssetPack       },
+		{ "SetLabelCacheSize",   spnlib_SDL_SetLabelCacheSize   },
+		{ "PollEvent",           spnlib_SDL_PollEvent           },
+		{ "NextEvent",           spnlib_SDL_NextEvent           },
+		{ "PollEvents",          spnlib_SDL_PollEvents          },
+		{ "SetEventCoalescing",  spnlib_SDL_SetEventCoalescing  },
+		{ "StartEventRecording", spnlib_SDL_StartEventRecording },
+		{ "StopEventRecording",  spnlib_SDL_StopEventRecording  },
+		{ "StartEventReplay",    spnlib_SDL_StartEventReplay    },
+		{ "StopEventReplay",     spnlib_SDL_StopEventReplay     },
+		{ "StartTimer",          spnlib_SDL_StartTimer          },
+		{ "StopTimer",           spnlib_SDL_StopTimer           },
+		{ "OpenMusic",           spnlib_SDL_OpenMusic           },
+		{ "OpenSample",          spnlib_SDL_OpenSample          },
+		{ "OpenChannels",        spnlib_SDL_OpenChannels        },
+		{ "GetError",            spnlib_SDL_GetError            },
+		{ "SetError",            spnlib_SDL_SetError            },
+		{ "GetMixError",         spnlib_SDL_GetMixError         },
+		{ "SetMixError",         spnlib_SDL_SetMixError         },
+		{ "GetPaths",            spnlib_SDL_GetPaths            },
+		{ "GetVersions",         spnlib_SDL_GetVersions         },
+		{ "GetPlatform",         spnlib_SDL_GetPlatform         },
+		{ "GetCPUSpecs",         spnlib_SDL_GetCPUSpecs         },
+		{ "GetPowerInfo",        spnlib_SDL_GetPowerInfo        },
+		{ "Delay",               spnlib_SDL_Delay               }
 	};
 
 	for (size_t i = 0; i < COUNT(fns); i++) {
@@ -86,6 +103,10 @@ static void spn_SDL_construct_library(void)
 
 	SpnHashMap *hm;
 	SPN_LIB_CREATE_NAMESPACE(Window);
+	SPN_LIB_CREATE_NAMESPACE(TextLabel);
+	SPN_LIB_CREATE_NAMESPACE(Console);
+	SPN_LIB_CREATE_NAMESPACE(TiledImage);
+	SPN_LIB_CREATE_NAMESPACE(Event);
 	SPN_LIB_CREATE_NAMESPACE(Music);
 	SPN_LIB_CREATE_NAMESPACE(Sample);
 	SPN_LIB_CREATE_NAMESPACE(Channels);
@@ -123,6 +144,10 @@ SPN_LIB_CLOSE_FUNC(ctx) {
 		// free hashmap representing library
 		spn_SDL_destroy_library();
 
+		// no events may be recorded or pushed from now on
+		spnlib_SDL_record_quit();
+		spnlib_sdl2_image_loader_quit();
+
 		// deinitialize SDL
 		SDL_Quit();
 	}
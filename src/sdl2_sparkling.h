@@ -74,11 +74,18 @@ SpnValue spn_get_lib_prototype(const char *classname);
 
 // Classes used for binding SDL types to Sparkling
 enum {
-	SPN_SDL_CLASS_UID_BASE    = SPN_USER_CLASS_UID_BASE + (('S' << 16) | ('F' << 8) | ('L' << 0)),
-	SPN_SDL_CLASS_UID_WINDOW  = SPN_SDL_CLASS_UID_BASE + 1,
-	SPN_SDL_CLASS_UID_TIMER   = SPN_SDL_CLASS_UID_BASE + 2,
-	SPN_SDL_CLASS_UID_TEXTURE = SPN_SDL_CLASS_UID_BASE + 3,
-	SPN_SDL_CLASS_UID_AUDIO   = SPN_SDL_CLASS_UID_BASE + 4
+	SPN_SDL_CLASS_UID_BASE        = SPN_USER_CLASS_UID_BASE + (('S' << 16) | ('F' << 8) | ('L' << 0)),
+	SPN_SDL_CLASS_UID_WINDOW      = SPN_SDL_CLASS_UID_BASE + 1,
+	SPN_SDL_CLASS_UID_TIMER       = SPN_SDL_CLASS_UID_BASE + 2,
+	SPN_SDL_CLASS_UID_TEXTURE     = SPN_SDL_CLASS_UID_BASE + 3,
+	SPN_SDL_CLASS_UID_AUDIO       = SPN_SDL_CLASS_UID_BASE + 4,
+	SPN_SDL_CLASS_UID_GRADIENT    = SPN_SDL_CLASS_UID_BASE + 5,
+	SPN_SDL_CLASS_UID_LABEL       = SPN_SDL_CLASS_UID_BASE + 6,
+	SPN_SDL_CLASS_UID_BITMAP_FONT = SPN_SDL_CLASS_UID_BASE + 7,
+	SPN_SDL_CLASS_UID_CONSOLE     = SPN_SDL_CLASS_UID_BASE + 8,
+	SPN_SDL_CLASS_UID_ASSET_PACK  = SPN_SDL_CLASS_UID_BASE + 9,
+	SPN_SDL_CLASS_UID_TILED_IMAGE = SPN_SDL_CLASS_UID_BASE + 10,
+	SPN_SDL_CLASS_UID_EVENT       = SPN_SDL_CLASS_UID_BASE + 11
 };
 
 #endif // SPNLIB_SDL2_H
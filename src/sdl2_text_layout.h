@@ -0,0 +1,165 @@
+//
+// sdl2_text_layout.h
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#ifndef SPNLIB_SDL2_TEXT_LAYOUT_H
+#define SPNLIB_SDL2_TEXT_LAYOUT_H
+
+#ifndef __cplusplus
+#error "sdl2_text_layout.h is only usable from C++"
+#endif
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+
+#include "sdl2_glyph.h"
+#include "sdl2_texture_cache.h"
+
+// A line of a text layout: the bytes [begin, end) of the text
+struct TextLine {
+	std::size_t begin, end;
+	int width; // excluding trailing spaces
+};
+
+struct TextLayout {
+	std::vector<TextLine> lines;
+	int width; // of the widest line
+};
+
+// Metrics of the glyphs of a font (TrueType or bitmap), and the
+// layouts of texts computed from them. Advances and kerning of code
+// points are provided by subclasses; they should be cheap to query.
+class TextMetrics {
+	struct LayoutKey {
+		std::string text;
+		int wrap_width;
+
+		bool operator==(const LayoutKey &that) const {
+			return wrap_width == that.wrap_width && text == that.text;
+		}
+	};
+
+	struct LayoutKeyHash {
+		std::size_t operator()(const LayoutKey &key) const {
+			std::size_t seed = std::hash<std::string>()(key.text);
+			texture_cache_hash_combine(seed, std::hash<int>()(key.wrap_width));
+			return seed;
+		}
+	};
+
+	typedef std::pair<LayoutKey, TextLayout> LayoutEntry;
+
+	// most recently used layout first
+	std::list<LayoutEntry> layouts;
+	std::unordered_map<
+		LayoutKey,
+		std::list<LayoutEntry>::iterator,
+		LayoutKeyHash
+	> layout_index;
+
+	static const std::size_t max_layouts = 256;
+
+	TextLayout compute_layout(const char *text, int wrap_width);
+
+public:
+	TextMetrics() {}
+
+	TextMetrics(const TextMetrics &) = delete;
+	TextMetrics &operator=(const TextMetrics &) = delete;
+
+	virtual ~TextMetrics() {}
+
+	virtual int advance(Uint32 cp) = 0;
+
+	// Kerning between two consecutive code points (0 if 'left' is 0)
+	virtual int kern(Uint32 left, Uint32 right) = 0;
+
+	// Distance between the tops of consecutive lines
+	virtual int line_skip() = 0;
+
+	// Height of a single line
+	virtual int height() = 0;
+
+	// Width of the widest line of 'text', including trailing spaces
+	int width(const char *text);
+
+	// Breaks 'text' into lines no wider than 'wrap_width' (unless
+	// a single character is wider). 0 means no limit. Layouts are
+	// cached, so that the same text is laid out only once.
+	const TextLayout &layout(const char *text, int wrap_width);
+
+	SPN_SDL_TextBoxSize box_size(const char *text, int wrap_width, int line_height);
+};
+
+// Draws each line of 'text' (separated by newline characters)
+// 'line_skip' pixels apart using 'draw_line', which is called as
+//     const char *draw_line(int x, int y, const char *begin, const char *end)
+// and is expected to draw the characters in [begin, end), stopping
+// early at a newline or NUL byte, and to return where it stopped.
+template<typename DrawLine>
+void draw_text_lines(int x, int y, const char *text, int line_skip, DrawLine draw_line)
+{
+	const char *unbounded = text + std::char_traits<char>::length(text);
+
+	while (true) {
+		text = draw_line(x, y, text, unbounded);
+
+		if (*text == 0) {
+			break;
+		}
+
+		text++; // skip newline
+		y += line_skip;
+	}
+}
+
+// Lays out 'text' using 'metrics', then draws its lines using
+// 'draw_line' (see above). See spnlib_sdl2_draw_text_box().
+template<typename DrawLine>
+void draw_text_box(
+	TextMetrics &metrics,
+	int x,
+	int y,
+	const char *text,
+	int wrap_width,
+	SPN_SDL_TextAlign align,
+	int line_height,
+	DrawLine draw_line
+)
+{
+	const TextLayout &layout = metrics.layout(text, wrap_width);
+
+	// without a wrap width, lines are aligned to the widest one
+	int box_width = wrap_width > 0 ? wrap_width : layout.width;
+
+	if (line_height <= 0) {
+		line_height = metrics.line_skip();
+	}
+
+	for (const TextLine &line : layout.lines) {
+		int offset = 0;
+
+		switch (align) {
+		case SPN_SDL_ALIGN_CENTER:
+			offset = (box_width - line.width) / 2;
+			break;
+		case SPN_SDL_ALIGN_RIGHT:
+			offset = box_width - line.width;
+			break;
+		case SPN_SDL_ALIGN_LEFT:
+		default:
+			break;
+		}
+
+		draw_line(x + offset, y, text + line.begin, text + line.end);
+		y += line_height;
+	}
+}
+
+#endif // SPNLIB_SDL2_TEXT_LAYOUT_H
@@ -15,6 +15,10 @@ static void spn_SDL_Texture_dtor(void *obj)
 {
 	spn_SDL_Texture *texture = obj;
 	SDL_DestroyTexture(texture->texture);
+
+	if (texture->mip) {
+		spn_object_release(texture->mip);
+	}
 }
 
 // A simple RAII class for managing SDL_Texture objects
@@ -28,18 +32,239 @@ const SpnClass spn_SDL_Texture_class = {
 };
 
 spn_SDL_Texture *spnlib_SDL_texture_new(SDL_Texture *texture)
+{
+	int w = 0, h = 0;
+
+	// querying NULL would replace the error that made it NULL
+	if (texture) {
+		SDL_QueryTexture(texture, NULL, NULL, &w, &h);
+	}
+
+	return spnlib_SDL_texture_new_sized(texture, w, h);
+}
+
+spn_SDL_Texture *spnlib_SDL_texture_new_sized(SDL_Texture *texture, int w, int h)
 {
 	spn_SDL_Texture *obj = spn_object_new(&spn_SDL_Texture_class);
 	obj->texture = texture;
+	obj->width = w;
+	obj->height = h;
+	obj->mip = NULL;
 	return obj;
 }
 
+spn_SDL_Texture *spnlib_SDL_texture_level_for_size(spn_SDL_Texture *texture, int w, int h)
+{
+	w = w < 0 ? -w : w;
+	h = h < 0 ? -h : h;
+
+	while (texture->mip && texture->mip->width >= w && texture->mip->height >= h) {
+		texture = texture->mip;
+	}
+
+	return texture;
+}
+
+Uint32 spnlib_SDL_preferred_texture_format(SDL_Renderer *renderer)
+{
+	SDL_RendererInfo info;
+
+	if (SDL_GetRendererInfo(renderer, &info) == 0) {
+		for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+			Uint32 format = info.texture_formats[i];
+
+			if (SDL_PIXELTYPE(format) == SDL_PIXELTYPE_PACKED32
+			 && SDL_PIXELLAYOUT(format) == SDL_PACKEDLAYOUT_8888
+			 && SDL_ISPIXELFORMAT_ALPHA(format)) {
+				return format;
+			}
+		}
+	}
+
+	return SDL_PIXELFORMAT_ARGB8888;
+}
+
+// Positions of the 8-bit color components within a 32-bit pixel.
+// 'ashift' is negative if there's no alpha channel.
+typedef struct PixelShifts {
+	int rshift, gshift, bshift, ashift;
+} PixelShifts;
+
+// Returns the position of an 8-bit-wide mask within a 32-bit word,
+// or -1 if 'mask' does not consist of 8 contiguous aligned bits
+static int byte_mask_shift(Uint32 mask)
+{
+	for (int shift = 0; shift < 32; shift += 8) {
+		if (mask == (Uint32)0xff << shift) {
+			return shift;
+		}
+	}
+
+	return -1;
+}
+
+// Returns false if 'format' is not a 32-bit format with 8-bit components
+static bool shifts_for_format(const SDL_PixelFormat *format, PixelShifts *shifts)
+{
+	if (format->BytesPerPixel != 4 || format->palette != NULL) {
+		return false;
+	}
+
+	shifts->rshift = byte_mask_shift(format->Rmask);
+	shifts->gshift = byte_mask_shift(format->Gmask);
+	shifts->bshift = byte_mask_shift(format->Bmask);
+	shifts->ashift = format->Amask ? byte_mask_shift(format->Amask) : -1;
+
+	return shifts->rshift >= 0
+	    && shifts->gshift >= 0
+	    && shifts->bshift >= 0
+	    && (shifts->ashift >= 0 || format->Amask == 0);
+}
+
+// Moves the color components of each pixel of a row to their positions in
+// the destination format. Sources without alpha get opaque pixels.
+// The loop body has no branches and the shifts are loop-invariant, so
+// at -O3 the compiler turns it into SIMD shifts and masks.
+static void swizzle_row(
+	Uint32 *restrict dst,
+	const Uint32 *restrict src,
+	int n,
+	PixelShifts from,
+	PixelShifts to
+)
+{
+	Uint32 amask = from.ashift >= 0 ? 0xff : 0x00;
+	Uint32 afill = from.ashift >= 0 ? 0x00 : 0xff;
+	int ashift = from.ashift >= 0 ? from.ashift : 0;
+
+	for (int i = 0; i < n; i++) {
+		Uint32 p = src[i];
+		Uint32 r = (p >> from.rshift) & 0xff;
+		Uint32 g = (p >> from.gshift) & 0xff;
+		Uint32 b = (p >> from.bshift) & 0xff;
+		Uint32 a = ((p >> ashift) & amask) | afill;
+
+		dst[i] = (r << to.rshift) | (g << to.gshift) | (b << to.bshift) | (a << to.ashift);
+	}
+}
+
+// Copies the pixels of a 32-bit surface into 'texture' of 'format',
+// swizzling them if the formats differ
+static void upload_pixels(SDL_Texture *texture, SDL_Surface *surface, Uint32 format)
+{
+	if (surface->format->format == format) {
+		SDL_UpdateTexture(texture, NULL, surface->pixels, surface->pitch);
+		return;
+	}
+
+	Uint32 *pixels = SDL_malloc((size_t)surface->w * surface->h * sizeof pixels[0]);
+	if (pixels == NULL) {
+		return;
+	}
+
+	SDL_PixelFormat *dst_format = SDL_AllocFormat(format);
+	PixelShifts from, to;
+
+	if (dst_format
+	 && shifts_for_format(surface->format, &from)
+	 && shifts_for_format(dst_format, &to)
+	 && to.ashift >= 0) {
+		for (int y = 0; y < surface->h; y++) {
+			const Uint32 *row = (const Uint32 *)((const Uint8 *)surface->pixels + y * surface->pitch);
+			swizzle_row(pixels + y * surface->w, row, surface->w, from, to);
+		}
+	} else {
+		// only happens with exotic texture formats
+		SDL_ConvertPixels(
+			surface->w,
+			surface->h,
+			surface->format->format,
+			surface->pixels,
+			surface->pitch,
+			format,
+			pixels,
+			surface->w * sizeof pixels[0]
+		);
+	}
+
+	SDL_UpdateTexture(texture, NULL, pixels, surface->w * sizeof pixels[0]);
+
+	SDL_FreeFormat(dst_format);
+	SDL_free(pixels);
+}
+
 spn_SDL_Texture *spnlib_SDL_texture_new_surface(
 	SDL_Renderer *renderer,
-	SDL_Surface *surface
+	SDL_Surface *surface,
+	Uint32 format
 )
 {
-	SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+	if (surface == NULL) {
+		return spnlib_SDL_texture_new(NULL);
+	}
+
+	Uint32 colorkey;
+	bool has_colorkey = SDL_GetColorKey(surface, &colorkey) == 0;
+	bool has_alpha = surface->format->Amask != 0 || surface->format->palette != NULL || has_colorkey;
+	PixelShifts shifts;
+
+	// 32-bit surfaces with 8-bit components (e. g. blended text or
+	// RGBA images) are swizzled directly; everything else (palettes,
+	// 24-bit images, color keys, etc.) is converted by SDL first.
+	SDL_Surface *source = surface;
+	SDL_Surface *converted = NULL;
+
+	if (has_colorkey || !shifts_for_format(surface->format, &shifts)) {
+		converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+
+		if (converted == NULL) {
+			SDL_FreeSurface(surface);
+			return spnlib_SDL_texture_new(NULL);
+		}
+
+		source = converted;
+	}
+
+	SDL_Texture *texture = SDL_CreateTexture(
+		renderer,
+		format,
+		SDL_TEXTUREACCESS_STATIC,
+		source->w,
+		source->h
+	);
+
+	if (texture) {
+		SDL_LockSurface(source);
+		upload_pixels(texture, source, format);
+		SDL_UnlockSurface(source);
+
+		SDL_SetTextureBlendMode(texture, has_alpha ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+	}
+
+	SDL_FreeSurface(converted);
 	SDL_FreeSurface(surface);
 	return spnlib_SDL_texture_new(texture);
 }
+
+spn_SDL_Texture *spnlib_SDL_texture_new_streaming(
+	SDL_Renderer *renderer,
+	int w,
+	int h,
+	Uint32 format
+)
+{
+	SDL_Texture *texture = SDL_CreateTexture(
+		renderer,
+		format,
+		SDL_TEXTUREACCESS_STREAMING,
+		w,
+		h
+	);
+
+	if (texture == NULL) {
+		return NULL;
+	}
+
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	return spnlib_SDL_texture_new(texture);
+}
@@ -17,6 +17,8 @@
 typedef struct spn_SDL_Texture {
 	SpnObject base;
 	SDL_Texture *texture;
+	int width, height; // logical size, used by renderTexture()
+	struct spn_SDL_Texture *mip; // retained; same image at half size, or NULL
 } spn_SDL_Texture;
 
 extern const SpnClass spn_SDL_Texture_class;
@@ -24,10 +26,43 @@ extern const SpnClass spn_SDL_Texture_class;
 // Transfers ownership of 'texture'
 SPN_API spn_SDL_Texture *spnlib_SDL_texture_new(SDL_Texture *texture);
 
+// Same as spnlib_SDL_texture_new(), but the texture will be stretched
+// to w * h when rendered, regardless of its actual size
+SPN_API spn_SDL_Texture *spnlib_SDL_texture_new_sized(
+	SDL_Texture *texture,
+	int w,
+	int h
+);
+
+// Returns the smallest mip level of 'texture' that is still at least
+// w * h pixels large (or the smallest level if there's none)
+SPN_API spn_SDL_Texture *spnlib_SDL_texture_level_for_size(
+	spn_SDL_Texture *texture,
+	int w,
+	int h
+);
+
+// Returns the first 32-bit format with an alpha channel among the
+// texture formats 'renderer' supports natively, or ARGB8888 if none.
+// Textures in this format can be uploaded without any conversion.
+SPN_API Uint32 spnlib_SDL_preferred_texture_format(SDL_Renderer *renderer);
+
+// Uploads the pixels of 'surface' into a texture of 'format',
+// which should be the preferred format of 'renderer'.
 // Deallocates 'surface'
 SPN_API spn_SDL_Texture *spnlib_SDL_texture_new_surface(
 	SDL_Renderer *renderer,
-	SDL_Surface *surface
+	SDL_Surface *surface,
+	Uint32 format
+);
+
+// Creates a blank, alpha-blended texture of size w * h that can be
+// updated (e. g. by the gradient functions) via SDL_LockTexture()
+SPN_API spn_SDL_Texture *spnlib_SDL_texture_new_streaming(
+	SDL_Renderer *renderer,
+	int w,
+	int h,
+	Uint32 format
 );
 
 #endif // SPNLIB_SDL2_TEXTURE_H
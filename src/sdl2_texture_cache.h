@@ -0,0 +1,172 @@
+//
+// sdl2_texture_cache.h
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#ifndef SPNLIB_SDL2_TEXTURE_CACHE_H
+#define SPNLIB_SDL2_TEXTURE_CACHE_H
+
+#ifndef __cplusplus
+#error "sdl2_texture_cache.h is only usable from C++"
+#endif
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <cstddef>
+
+#include "sdl2_texture.h"
+
+// Least-recently-used cache of texture objects with a capacity in bytes.
+// Caching is disabled while the capacity is 0, which is the default.
+template<typename Key, typename Hash>
+class TextureCache {
+	struct Entry {
+		Key key;
+		spn_SDL_Texture *texture;
+		std::size_t bytes;
+	};
+
+	// most recently used entry first
+	std::list<Entry> entries;
+	std::unordered_map<
+		Key,
+		typename std::list<Entry>::iterator,
+		Hash
+	> index;
+
+	std::size_t capacity;
+	std::size_t size;
+
+	unsigned long hits;
+	unsigned long misses;
+
+	std::function<void(const Key &)> on_evict;
+
+	void evict_until_fits(std::size_t limit)
+	{
+		while (size > limit && entries.empty() == false) {
+			Entry &victim = entries.back();
+			size -= victim.bytes;
+			spn_object_release(victim.texture);
+
+			if (on_evict) {
+				on_evict(victim.key);
+			}
+
+			index.erase(victim.key);
+			entries.pop_back();
+		}
+	}
+
+public:
+	TextureCache() : capacity(0), size(0), hits(0), misses(0) {}
+
+	TextureCache(const TextureCache &) = delete;
+	TextureCache &operator=(const TextureCache &) = delete;
+
+	~TextureCache()
+	{
+		purge();
+	}
+
+	std::size_t get_capacity() const
+	{
+		return capacity;
+	}
+
+	std::size_t get_size() const
+	{
+		return size;
+	}
+
+	std::size_t get_count() const
+	{
+		return entries.size();
+	}
+
+	unsigned long get_hits() const
+	{
+		return hits;
+	}
+
+	unsigned long get_misses() const
+	{
+		return misses;
+	}
+
+	void set_capacity(std::size_t bytes)
+	{
+		capacity = bytes;
+		evict_until_fits(capacity);
+	}
+
+	void purge()
+	{
+		evict_until_fits(0);
+	}
+
+	// 'handler' is called with the key of each entry evicted to make room
+	// or purged, so that data kept alongside the cache can be dropped too
+	// (entries removed by erase() are not reported)
+	void set_eviction_handler(const std::function<void(const Key &)> &handler)
+	{
+		on_evict = handler;
+	}
+
+	// Returns a borrowed reference, or NULL if 'key' is not cached
+	spn_SDL_Texture *lookup(const Key &key)
+	{
+		auto it = index.find(key);
+		if (it == index.end()) {
+			misses++;
+			return NULL;
+		}
+
+		// mark entry as most recently used
+		hits++;
+		entries.splice(entries.begin(), entries, it->second);
+		return it->second->texture;
+	}
+
+	// Drops the entry of 'key' (e. g. because it's stale), if any
+	void erase(const Key &key)
+	{
+		auto it = index.find(key);
+		if (it == index.end()) {
+			return;
+		}
+
+		size -= it->second->bytes;
+		spn_object_release(it->second->texture);
+		entries.erase(it->second);
+		index.erase(it);
+	}
+
+	// Retains 'texture' if it is cached; returns whether it is
+	bool insert(const Key &key, spn_SDL_Texture *texture, std::size_t bytes)
+	{
+		// textures larger than the entire cache are never cached
+		if (bytes > capacity) {
+			return false;
+		}
+
+		evict_until_fits(capacity - bytes);
+
+		spn_object_retain(texture);
+		entries.push_front({ key, texture, bytes });
+		index[key] = entries.begin();
+		size += bytes;
+		return true;
+	}
+};
+
+// Combines hash values, like boost::hash_combine()
+inline void texture_cache_hash_combine(std::size_t &seed, std::size_t h)
+{
+	seed ^= h + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+#endif // SPNLIB_SDL2_TEXTURE_CACHE_H
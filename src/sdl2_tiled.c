@@ -0,0 +1,684 @@
+//
+// sdl2_tiled.c
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#include <math.h>
+
+#include "sdl2_tiled.h"
+#include "sdl2_sparkling.h"
+#include "sdl2_window.h"
+#include "sdl2_image.h"
+#include "helpers.h"
+
+/////////////////////////////////
+//  TiledImage Class structure //
+/////////////////////////////////
+
+typedef struct TiledTile {
+	SDL_Texture *texture; // NULL if not uploaded (or evicted)
+	size_t bytes; // size of 'texture'
+	Uint32 used; // number of the last draw it was visible in
+
+	// links of the list of uploaded tiles, most recently used first
+	struct TiledTile *prev, *next;
+} TiledTile;
+
+// Level n of the pyramid is the image downscaled by 2^n
+typedef struct TiledLevel {
+	SDL_Surface *surface;
+	int cols, rows;
+	TiledTile *tiles; // row-major
+} TiledLevel;
+
+// An image that is decoded once and kept in memory along with its
+// downscaled versions, but uploaded only in tiles, and only the tiles
+// intersecting the view (at the level matching the zoom) are uploaded.
+// Uploaded tiles share a memory budget; when it is exceeded, the least
+// recently visible tiles are freed.
+typedef struct spn_SDL_TiledImage {
+	SpnObject base;
+	spn_SDL_Window *window; // retained, since the textures belong to its renderer
+
+	int tile_size;
+	int n_levels;
+	TiledLevel *levels;
+
+	TiledTile *lru_head, *lru_tail;
+	size_t bytes;
+	size_t capacity;
+
+	int upload_limit; // number of tiles uploaded per draw at most
+	Uint32 frame; // number of draws so far
+
+	// links of the list of all tiled images
+	struct spn_SDL_TiledImage *prev, *next;
+} spn_SDL_TiledImage;
+
+static spn_SDL_TiledImage *tiled_images = NULL;
+
+static const int default_tile_size = 256;
+static const size_t default_capacity = 64 * 1024 * 1024;
+static const int default_upload_limit = 8;
+
+// Averages 2 * 2 blocks of pixels. Each byte is averaged separately,
+// which is correct for every 32-bit format with 8-bit components.
+static SDL_Surface *halve_surface(SDL_Surface *src)
+{
+	int w = (src->w + 1) / 2;
+	int h = (src->h + 1) / 2;
+
+	SDL_Surface *dst = SDL_CreateRGBSurface(
+		0,
+		w,
+		h,
+		32,
+		src->format->Rmask,
+		src->format->Gmask,
+		src->format->Bmask,
+		src->format->Amask
+	);
+
+	if (dst == NULL) {
+		return NULL;
+	}
+
+	for (int y = 0; y < h; y++) {
+		const Uint8 *row0 = (const Uint8 *)src->pixels + 2 * y * src->pitch;
+		const Uint8 *row1 = 2 * y + 1 < src->h ? row0 + src->pitch : row0;
+		Uint8 *out = (Uint8 *)dst->pixels + y * dst->pitch;
+
+		for (int x = 0; x < w; x++) {
+			int x0 = 2 * x * 4;
+			int x1 = 2 * x + 1 < src->w ? x0 + 4 : x0;
+
+			for (int c = 0; c < 4; c++) {
+				out[x * 4 + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4;
+			}
+		}
+	}
+
+	return dst;
+}
+
+static TiledTile *tiled_tile(spn_SDL_TiledImage *image, int level, int tx, int ty)
+{
+	TiledLevel *l = &image->levels[level];
+	return &l->tiles[ty * l->cols + tx];
+}
+
+static void lru_unlink(spn_SDL_TiledImage *image, TiledTile *tile)
+{
+	if (tile->prev) {
+		tile->prev->next = tile->next;
+	} else {
+		image->lru_head = tile->next;
+	}
+
+	if (tile->next) {
+		tile->next->prev = tile->prev;
+	} else {
+		image->lru_tail = tile->prev;
+	}
+
+	tile->prev = tile->next = NULL;
+}
+
+static void lru_push_front(spn_SDL_TiledImage *image, TiledTile *tile)
+{
+	tile->prev = NULL;
+	tile->next = image->lru_head;
+
+	if (image->lru_head) {
+		image->lru_head->prev = tile;
+	} else {
+		image->lru_tail = tile;
+	}
+
+	image->lru_head = tile;
+}
+
+static void tiled_evict(spn_SDL_TiledImage *image, TiledTile *tile)
+{
+	lru_unlink(image, tile);
+	SDL_DestroyTexture(tile->texture);
+	tile->texture = NULL;
+	image->bytes -= tile->bytes;
+	tile->bytes = 0;
+}
+
+static void tiled_release_textures(spn_SDL_TiledImage *image)
+{
+	while (image->lru_head) {
+		tiled_evict(image, image->lru_head);
+	}
+}
+
+// Frees the least recently visible tiles until the budget is met.
+// Tiles visible in the current frame are kept even if it isn't.
+static void tiled_trim(spn_SDL_TiledImage *image)
+{
+	while (image->bytes > image->capacity
+	    && image->lru_tail
+	    && image->lru_tail->used != image->frame) {
+		tiled_evict(image, image->lru_tail);
+	}
+}
+
+// Uploads the pixels of a tile straight from the surface of its level
+static bool tiled_upload(spn_SDL_TiledImage *image, int level, int tx, int ty)
+{
+	TiledTile *tile = tiled_tile(image, level, tx, ty);
+	SDL_Surface *surface = image->levels[level].surface;
+	int x = tx * image->tile_size;
+	int y = ty * image->tile_size;
+	int w = surface->w - x < image->tile_size ? surface->w - x : image->tile_size;
+	int h = surface->h - y < image->tile_size ? surface->h - y : image->tile_size;
+
+	SDL_Texture *texture = SDL_CreateTexture(
+		image->window->renderer,
+		surface->format->format,
+		SDL_TEXTUREACCESS_STATIC,
+		w,
+		h
+	);
+
+	if (texture == NULL) {
+		return false;
+	}
+
+	const Uint8 *pixels = (const Uint8 *)surface->pixels + y * surface->pitch + x * 4;
+	SDL_UpdateTexture(texture, NULL, pixels, surface->pitch);
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	tile->texture = texture;
+	tile->bytes = (size_t)w * h * 4;
+	image->bytes += tile->bytes;
+	lru_push_front(image, tile);
+
+	return true;
+}
+
+// Where the image is drawn: 'dst' shows the image from (view_x, view_y)
+// (in pixels of the original image) onwards, scaled by 'zoom'
+typedef struct TiledView {
+	SDL_Rect dst;
+	double view_x, view_y;
+	double zoom;
+} TiledView;
+
+// Draws the part of a tile of 'level' that lies within 'src' (a
+// rectangle in the coordinates of that level). The edges of the
+// destination are rounded independently, so adjacent tiles don't
+// leave gaps between them.
+static void tiled_render(
+	spn_SDL_TiledImage *image,
+	const TiledView *view,
+	int level,
+	int tx,
+	int ty,
+	SDL_Rect src
+)
+{
+	TiledTile *tile = tiled_tile(image, level, tx, ty);
+	double scale = 1 << level;
+
+	// edges in the coordinates of the original image, then in the window
+	int x0 = lround(view->dst.x + (src.x * scale - view->view_x) * view->zoom);
+	int y0 = lround(view->dst.y + (src.y * scale - view->view_y) * view->zoom);
+	int x1 = lround(view->dst.x + ((src.x + src.w) * scale - view->view_x) * view->zoom);
+	int y1 = lround(view->dst.y + ((src.y + src.h) * scale - view->view_y) * view->zoom);
+
+	SDL_Rect rel = {
+		src.x - tx * image->tile_size,
+		src.y - ty * image->tile_size,
+		src.w,
+		src.h
+	};
+
+	SDL_Rect dst = { x0, y0, x1 - x0, y1 - y0 };
+	SDL_RenderCopy(image->window->renderer, tile->texture, &rel, &dst);
+
+	tile->used = image->frame;
+	lru_unlink(image, tile);
+	lru_push_front(image, tile);
+}
+
+// Draws a tile of 'level', uploading it if the upload limit of this
+// draw allows. Otherwise, the same area is drawn from the nearest
+// coarser level that is uploaded; the single tile of the coarsest
+// level is always uploaded, so there is always something to show.
+static void tiled_draw_tile(
+	spn_SDL_TiledImage *image,
+	const TiledView *view,
+	int level,
+	int tx,
+	int ty,
+	int *uploads
+)
+{
+	SDL_Surface *surface = image->levels[level].surface;
+	SDL_Rect src = {
+		tx * image->tile_size,
+		ty * image->tile_size,
+		0,
+		0
+	};
+
+	src.w = surface->w - src.x < image->tile_size ? surface->w - src.x : image->tile_size;
+	src.h = surface->h - src.y < image->tile_size ? surface->h - src.y : image->tile_size;
+
+	for (int l = level; l < image->n_levels; l++) {
+		int shift = l - level;
+		int ptx = tx >> shift;
+		int pty = ty >> shift;
+		TiledTile *tile = tiled_tile(image, l, ptx, pty);
+
+		if (tile->texture == NULL) {
+			bool coarsest = l == image->n_levels - 1;
+
+			if (coarsest || *uploads < image->upload_limit) {
+				if (!tiled_upload(image, l, ptx, pty)) {
+					continue;
+				}
+
+				(*uploads)++;
+			} else {
+				continue;
+			}
+		}
+
+		// the area of the tile in the coordinates of level 'l'
+		SDL_Surface *ls = image->levels[l].surface;
+		int x0 = src.x >> shift;
+		int y0 = src.y >> shift;
+		int x1 = (src.x + src.w + (1 << shift) - 1) >> shift;
+		int y1 = (src.y + src.h + (1 << shift) - 1) >> shift;
+
+		SDL_Rect area = {
+			x0,
+			y0,
+			(x1 < ls->w ? x1 : ls->w) - x0,
+			(y1 < ls->h ? y1 : ls->h) - y0
+		};
+
+		tiled_render(image, view, l, ptx, pty, area);
+		return;
+	}
+}
+
+static void tiled_draw(spn_SDL_TiledImage *image, const TiledView *view)
+{
+	SDL_Renderer *renderer = image->window->renderer;
+
+	image->frame++;
+
+	// the coarsest level that still has at least one pixel per pixel
+	int level = 0;
+	while (level + 1 < image->n_levels && view->zoom * (1 << (level + 1)) <= 1.0) {
+		level++;
+	}
+
+	// the visible area in the coordinates of 'level'
+	double scale = 1 << level;
+	double lx0 = view->view_x / scale;
+	double ly0 = view->view_y / scale;
+	double lx1 = lx0 + view->dst.w / view->zoom / scale;
+	double ly1 = ly0 + view->dst.h / view->zoom / scale;
+
+	TiledLevel *l = &image->levels[level];
+	int tx0 = floor(lx0 / image->tile_size);
+	int ty0 = floor(ly0 / image->tile_size);
+	int tx1 = ceil(lx1 / image->tile_size) - 1;
+	int ty1 = ceil(ly1 / image->tile_size) - 1;
+
+	tx0 = tx0 < 0 ? 0 : tx0;
+	ty0 = ty0 < 0 ? 0 : ty0;
+	tx1 = tx1 >= l->cols ? l->cols - 1 : tx1;
+	ty1 = ty1 >= l->rows ? l->rows - 1 : ty1;
+
+	// draw only within 'dst', and within the clip rectangle, if any
+	SDL_Rect old_clip, clip = view->dst;
+	SDL_RenderGetClipRect(renderer, &old_clip);
+
+	if (!SDL_RectEmpty(&old_clip) && !SDL_IntersectRect(&old_clip, &view->dst, &clip)) {
+		return;
+	}
+
+	SDL_RenderSetClipRect(renderer, &clip);
+
+	int uploads = 0;
+
+	for (int ty = ty0; ty <= ty1; ty++) {
+		for (int tx = tx0; tx <= tx1; tx++) {
+			tiled_draw_tile(image, view, level, tx, ty, &uploads);
+		}
+	}
+
+	SDL_RenderSetClipRect(renderer, SDL_RectEmpty(&old_clip) ? NULL : &old_clip);
+
+	tiled_trim(image);
+}
+
+static void spn_SDL_TiledImage_dtor(void *o)
+{
+	spn_SDL_TiledImage *image = o;
+
+	if (image->prev) {
+		image->prev->next = image->next;
+	} else {
+		tiled_images = image->next;
+	}
+
+	if (image->next) {
+		image->next->prev = image->prev;
+	}
+
+	tiled_release_textures(image);
+
+	for (int i = 0; i < image->n_levels; i++) {
+		SDL_FreeSurface(image->levels[i].surface);
+		SDL_free(image->levels[i].tiles);
+	}
+
+	SDL_free(image->levels);
+	spn_object_release(image->window);
+}
+
+static const SpnClass spn_SDL_TiledImage_class = {
+	sizeof(spn_SDL_TiledImage),
+	SPN_SDL_CLASS_UID_TILED_IMAGE,
+	NULL,
+	NULL,
+	NULL,
+	spn_SDL_TiledImage_dtor
+};
+
+static spn_SDL_TiledImage *tiled_from_hashmap(SpnHashMap *hm)
+{
+	SpnValue objv = spn_hashmap_get_strkey(hm, "tiled");
+
+	if (!spn_isstrguserinfo(&objv)) {
+		return NULL;
+	}
+
+	spn_SDL_TiledImage *image = spn_objvalue(&objv);
+
+	if (!spn_object_member_of_class(image, &spn_SDL_TiledImage_class)) {
+		return NULL;
+	}
+
+	return image;
+}
+
+#define CHECK_FOR_TILED_HASHMAP(argnum)                                      \
+	CHECK_ARG_RETURN_ON_ERROR(argnum, hashmap);                              \
+	spn_SDL_TiledImage *image = tiled_from_hashmap(HASHMAPARG(argnum));      \
+	if (image == NULL) {                                                     \
+		spn_ctx_runtime_error(ctx, "tiled image object is invalid", NULL);   \
+		return -1;                                                           \
+	}
+
+// Builds the pyramid, down to the level that fits in a single tile.
+// Takes ownership of 'surface'.
+static bool tiled_build_levels(spn_SDL_TiledImage *image, SDL_Surface *surface)
+{
+	int n_levels = 1;
+	for (int w = surface->w, h = surface->h; w > image->tile_size || h > image->tile_size; n_levels++) {
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+	}
+
+	image->levels = SDL_calloc(n_levels, sizeof image->levels[0]);
+	if (image->levels == NULL) {
+		SDL_FreeSurface(surface);
+		return false;
+	}
+
+	for (int i = 0; i < n_levels; i++) {
+		if (i > 0) {
+			surface = halve_surface(image->levels[i - 1].surface);
+			if (surface == NULL) {
+				return false;
+			}
+		}
+
+		TiledLevel *level = &image->levels[i];
+		level->surface = surface;
+		level->cols = (surface->w + image->tile_size - 1) / image->tile_size;
+		level->rows = (surface->h + image->tile_size - 1) / image->tile_size;
+		level->tiles = SDL_calloc((size_t)level->cols * level->rows, sizeof level->tiles[0]);
+		image->n_levels = i + 1;
+
+		if (level->tiles == NULL) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/////////////////////////////////
+// Initialize TiledImage Class //
+/////////////////////////////////
+
+// Loads an image for drawing in parts, at any zoom level. Returns nil
+// if the image can't be loaded.
+// Parameters:
+// 0. the window object
+// 1. the file name
+// 2. (optional) width and height of the tiles in pixels (default: 256)
+int spnlib_SDL_Window_loadTiledImage(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	spn_SDL_Window *window = window_from_hashmap(HASHMAPARG(0));
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	double tile_size = default_tile_size;
+
+	if (argc > 2) {
+		CHECK_ARG_RETURN_ON_ERROR(2, number);
+		tile_size = NUMARG(2);
+	}
+
+	// tiles must fit in a texture
+	SDL_RendererInfo info;
+	int max_size = 4096;
+
+	if (SDL_GetRendererInfo(window->renderer, &info) == 0) {
+		if (info.max_texture_width > 0 && info.max_texture_width < max_size) {
+			max_size = info.max_texture_width;
+		}
+
+		if (info.max_texture_height > 0 && info.max_texture_height < max_size) {
+			max_size = info.max_texture_height;
+		}
+	}
+
+	if (tile_size < 16 || tile_size > max_size) {
+		spn_ctx_runtime_error(ctx, "invalid tile size", NULL);
+		return -2;
+	}
+
+	SDL_Surface *surface = spnlib_sdl2_decode_image(STRARG(1), window->format);
+
+	if (surface == NULL) {
+		return 0;
+	}
+
+	spn_SDL_TiledImage *image = spn_object_new(&spn_SDL_TiledImage_class);
+
+	spn_object_retain(window);
+	image->window = window;
+
+	image->tile_size = tile_size;
+	image->n_levels = 0;
+	image->levels = NULL;
+
+	image->lru_head = image->lru_tail = NULL;
+	image->bytes = 0;
+	image->capacity = default_capacity;
+
+	image->upload_limit = default_upload_limit;
+	image->frame = 0;
+
+	image->prev = NULL;
+	image->next = tiled_images;
+	if (tiled_images) {
+		tiled_images->prev = image;
+	}
+	tiled_images = image;
+
+	if (!tiled_build_levels(image, surface)) {
+		spn_object_release(image);
+		spn_ctx_runtime_error(ctx, "out of memory for tiled image", NULL);
+		return -3;
+	}
+
+	// construct return value
+	*ret = spn_makehashmap();
+	SpnHashMap *hm = spn_hashmapvalue(ret);
+
+	// set its prototype
+	SpnValue proto = spn_get_lib_prototype("TiledImage");
+	spn_hashmap_set_strkey(hm, "super", &proto);
+
+	SpnValue tiledval = spn_makestrguserinfo(image);
+	spn_hashmap_set_strkey(hm, "tiled", &tiledval);
+	spn_value_release(&tiledval);
+
+	return 0;
+}
+
+void spnlib_SDL_tiled_release_textures(void)
+{
+	for (spn_SDL_TiledImage *image = tiled_images; image; image = image->next) {
+		tiled_release_textures(image);
+	}
+}
+
+/////////////////////////////////
+//     TiledImage methods      //
+/////////////////////////////////
+
+// Draws a part of the image into a rectangle of the window.
+// Tiles that aren't uploaded yet are drawn from a lower-resolution
+// level, until they are uploaded by a subsequent draw.
+// Parameters:
+// 0. the tiled image object
+// 1, 2. X and Y coordinates of the top left corner of the rectangle
+// 3, 4. width and height of the rectangle
+// 5, 6. the point of the image (in pixels of the original image)
+//       shown in the top left corner
+// 7. (optional) scale factor of the image (default: 1)
+static int spnlib_SDL_TiledImage_draw(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_TILED_HASHMAP(0);
+
+	for (int i = 1; i <= 6; i++) {
+		CHECK_ARG_RETURN_ON_ERROR(i, number);
+	}
+
+	TiledView view = {
+		{ NUMARG(1), NUMARG(2), NUMARG(3), NUMARG(4) },
+		NUMARG(5),
+		NUMARG(6),
+		1.0
+	};
+
+	if (argc > 7) {
+		CHECK_ARG_RETURN_ON_ERROR(7, number);
+		view.zoom = NUMARG(7);
+	}
+
+	if (view.zoom <= 0) {
+		spn_ctx_runtime_error(ctx, "zoom must be positive", NULL);
+		return -2;
+	}
+
+	if (view.dst.w > 0 && view.dst.h > 0) {
+		tiled_draw(image, &view);
+	}
+
+	return 0;
+}
+
+// Sets the maximal total size of the uploaded tiles in bytes (the
+// default is 64 megabytes). The tiles visible in a single draw are
+// kept even if they exceed it.
+static int spnlib_SDL_TiledImage_setTileBudget(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_TILED_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+
+	double bytes = NUMARG(1);
+	image->capacity = bytes > 0 ? bytes : 0;
+	tiled_trim(image);
+
+	return 0;
+}
+
+// Sets the maximal number of tiles uploaded by a single draw (the
+// default is 8), which bounds the time spent drawing a frame
+static int spnlib_SDL_TiledImage_setUploadLimit(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_TILED_HASHMAP(0);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+
+	double limit = NUMARG(1);
+	image->upload_limit = limit < 1 ? 1 : limit > 1024 ? 1024 : limit;
+
+	return 0;
+}
+
+// Returns a hashmap with keys "width" and "height" (of the original
+// image), "tileSize", "levels", "tiles" (number of uploaded tiles)
+// and "bytes" (their total size)
+static int spnlib_SDL_TiledImage_stats(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_FOR_TILED_HASHMAP(0);
+
+	long tiles = 0;
+	for (TiledTile *tile = image->lru_head; tile; tile = tile->next) {
+		tiles++;
+	}
+
+	*ret = spn_makehashmap();
+	SpnHashMap *stats = spn_hashmapvalue(ret);
+
+	set_integer_property(stats, "width", image->levels[0].surface->w);
+	set_integer_property(stats, "height", image->levels[0].surface->h);
+	set_integer_property(stats, "tileSize", image->tile_size);
+	set_integer_property(stats, "levels", image->n_levels);
+	set_integer_property(stats, "tiles", tiles);
+	set_integer_property(stats, "bytes", image->bytes);
+
+	return 0;
+}
+
+/////////////////////////////////
+// TiledImage methods creation //
+/////////////////////////////////
+void spnlib_SDL_methods_for_TiledImage(SpnHashMap *tiled)
+{
+	static const SpnExtFunc methods[] = {
+		{ "draw",           spnlib_SDL_TiledImage_draw           },
+		{ "setTileBudget",  spnlib_SDL_TiledImage_setTileBudget  },
+		{ "setUploadLimit", spnlib_SDL_TiledImage_setUploadLimit },
+		{ "stats",          spnlib_SDL_TiledImage_stats          }
+	};
+
+	for (size_t i = 0; i < COUNT(methods); i++) {
+		SpnValue fnval = spn_makenativefunc(methods[i].name, methods[i].fn);
+		spn_hashmap_set_strkey(tiled, methods[i].name, &fnval);
+		spn_value_release(&fnval);
+	}
+}
@@ -0,0 +1,26 @@
+//
+// sdl2_tiled.h
+// sdl2-sparkling
+//
+// Licensed under the 2-clause BSD License
+//
+
+#ifndef SPNLIB_SDL2_TILED_H
+#define SPNLIB_SDL2_TILED_H
+
+#include <spn/ctx.h>
+#include <spn/api.h>
+
+#include <SDL2/SDL.h>
+
+// Window.loadTiledImage(); argument #0 is the window object
+int spnlib_SDL_Window_loadTiledImage(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
+
+// Frees the tile textures of every tiled image.
+// They are uploaded again when next drawn.
+void spnlib_SDL_tiled_release_textures(void);
+
+// In order to bridge data between sdl2_sparkling.c and this file
+void spnlib_SDL_methods_for_TiledImage(SpnHashMap *tiled);
+
+#endif // SPNLIB_SDL2_TILED_H
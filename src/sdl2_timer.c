@@ -10,6 +10,7 @@
 
 #include "sdl2_timer.h"
 #include "sdl2_sparkling.h"
+#include "sdl2_event.h"
 
 typedef struct spn_SDL_Timer {
 	SpnObject base;
@@ -51,6 +52,7 @@ static Uint32 native_timer_callback(Uint32 delay, void *data)
 		SDL_Event event;
 		SDL_zero(event);
 		event.type = SDL_USEREVENT;
+		event.user.code = SPN_SDL_USEREVENT_TIMER;
 		event.user.data1 = timer;
 		SDL_PushEvent(&event);
 	}
@@ -9,6 +9,7 @@
 //
 
 #include "sdl2_ttf.h"
+#include "sdl2_texture_cache.h"
 
 #include <unordered_map>
 #include <memory>
@@ -40,77 +41,87 @@ static const struct TTF_InitGuard {
 	}
 } initGuard;
 
-struct FontKey {
-	const char *name;
-	int ptsize;
-
-	bool operator==(FontKey that) const {
-		return std::strcmp(name, that.name) == 0 && ptsize == that.ptsize;
+struct FontDeleter {
+	void operator()(TTF_Font *font) const {
+		TTF_CloseFont(font);
 	}
 };
 
-namespace std {
-	template<>
-	struct hash<const char *> {
-		size_t operator()(const char *str) {
-			size_t h = 5381;
-			for (const char *p = str; *p; p++) {
-				h *= 33;
-				h ^= static_cast<unsigned char>(*p);
-			}
-			return h;
-		}
-	};
+// The contents of a font file, read only once, and the faces
+// opened from it. Faces read the file through SDL_RWops
+// pointing into 'data', which therefore must outlive them
+// (members are destroyed in reverse order of declaration).
+struct FontFile {
+	std::vector<char> data;
+	std::unordered_map<int, std::unique_ptr<TTF_Font, FontDeleter>> faces;
+};
 
-	template<>
-	struct hash<FontKey> {
-		size_t operator()(FontKey key) const {
-			return std::hash<const char *>()(key.name) ^ std::hash<int>()(key.ptsize);
+// Font files by name (without the ".ttf" extension)
+static std::unordered_map<std::string, std::unique_ptr<FontFile>> font_files;
+
+// Style masks by style string, so that each string is parsed once
+static std::unordered_map<std::string, int> style_masks;
+
+static FontFile *load_font_file(const std::string &name)
+{
+	auto &file = font_files[name];
+
+	if (file == nullptr) {
+		std::ifstream stream(name + ".ttf", std::ios::binary);
+
+		// don't remember failures, so that the file may appear later
+		if (!stream) {
+			font_files.erase(name);
+			return nullptr;
 		}
-	};
+
+		file.reset(new FontFile);
+		file->data.assign(
+			std::istreambuf_iterator<char> { stream },
+			std::istreambuf_iterator<char> {}
+		);
+	}
+
+	return file.get();
 }
 
-#include <iostream>
+static TTF_Font *open_font(const char *name, int ptsize)
+{
+	FontFile *file = load_font_file(name);
 
-struct FontDeleter {
-	void operator()(TTF_Font *font) const {
-		TTF_CloseFont(font);
+	if (file == nullptr) {
+		return nullptr;
 	}
-};
 
-TTF_Font *spnlib_sdl2_get_font(
-	const char *name,
-	int ptsize,
-	const char *style
-)
-{
-	static std::unordered_map<
-		FontKey,
-		std::unique_ptr<
-			TTF_Font,
-			FontDeleter
-		>
-	> cache;
-
-	auto &ptr = cache[{ name, ptsize }];
-
-	if (ptr == nullptr) {
-		std::string fname(name);
-		fname += ".ttf";
-		ptr = std::unique_ptr<TTF_Font, FontDeleter> {
-			TTF_OpenFont(fname.c_str(), ptsize)
-		};
+	auto &face = file->faces[ptsize];
+
+	if (face == nullptr) {
+		SDL_RWops *rw = SDL_RWFromConstMem(file->data.data(), file->data.size());
+
+		// the face closes 'rw' when it is closed
+		face.reset(rw ? TTF_OpenFontRW(rw, 1, ptsize) : nullptr);
+
+		if (face == nullptr) {
+			file->faces.erase(ptsize);
+			return nullptr;
+		}
 	}
 
-	// could not open font
-	if (ptr == nullptr) {
-		return nullptr;
+	return face.get();
+}
+
+static int style_mask(const char *style)
+{
+	if (style == nullptr) {
+		style = "normal";
 	}
 
-	TTF_Font *font = ptr.get();
+	auto it = style_masks.find(style);
+	if (it != style_masks.end()) {
+		return it->second;
+	}
 
-	// Set style
-	static std::unordered_map<std::string, int> styles {
+	static const std::unordered_map<std::string, int> styles {
 		{ "bold",          TTF_STYLE_BOLD          },
 		{ "italic",        TTF_STYLE_ITALIC        },
 		{ "underline",     TTF_STYLE_UNDERLINE     },
@@ -118,10 +129,6 @@ TTF_Font *spnlib_sdl2_get_font(
 		{ "normal",        TTF_STYLE_NORMAL        }
 	};
 
-	if (style == nullptr) {
-		style = "normal";
-	}
-
 	std::istringstream sss(style);
 	std::vector<std::string> stylev {
 		std::istream_iterator<std::string> { sss },
@@ -130,18 +137,96 @@ TTF_Font *spnlib_sdl2_get_font(
 
 	int stylemask = TTF_STYLE_NORMAL;
 	for (const auto &s : stylev) {
-		stylemask |= styles[s];
+		auto flag = styles.find(s);
+		if (flag != styles.end()) {
+			stylemask |= flag->second;
+		}
+	}
+
+	style_masks.emplace(style, stylemask);
+	return stylemask;
+}
+
+TTF_Font *spnlib_sdl2_get_font(
+	const char *name,
+	int ptsize,
+	const char *style
+)
+{
+	TTF_Font *font = open_font(name, ptsize);
+
+	// could not open font
+	if (font == nullptr) {
+		return nullptr;
 	}
 
-	TTF_SetFontStyle(font, stylemask);
+	// Set style. SDL_ttf flushes its glyph cache
+	// even if the style doesn't actually change.
+	int stylemask = style_mask(style);
+
+	if (TTF_GetFontStyle(font) != stylemask) {
+		TTF_SetFontStyle(font, stylemask);
+	}
 
 	return font;
 }
 
+TTF_Font *spnlib_sdl2_get_font_unstyled(
+	const char *name,
+	int ptsize,
+	const char *style,
+	int *stylemask
+)
+{
+	*stylemask = style_mask(style);
+	return open_font(name, ptsize);
+}
+
+bool spnlib_sdl2_preload_font(const char *name, int ptsize)
+{
+	return open_font(name, ptsize) != nullptr;
+}
+
+// Rendered text depends on the style of the font as well,
+// which may have been changed since the font was loaded
+struct TextKey {
+	TTF_Font *font;
+	int style;
+	Uint32 color; // RGBA, 8 bits per channel
+	bool hq;
+	std::string text;
+
+	bool operator==(const TextKey &that) const {
+		return font == that.font
+		    && style == that.style
+		    && color == that.color
+		    && hq == that.hq
+		    && text == that.text;
+	}
+};
+
+struct TextKeyHash {
+	std::size_t operator()(const TextKey &key) const {
+		std::size_t h = std::hash<std::string>()(key.text);
+		texture_cache_hash_combine(h, std::hash<TTF_Font *>()(key.font));
+		texture_cache_hash_combine(h, std::hash<int>()(key.style));
+		texture_cache_hash_combine(h, std::hash<Uint32>()(key.color));
+		texture_cache_hash_combine(h, key.hq);
+		return h;
+	}
+};
+
+typedef TextureCache<TextKey, TextKeyHash> TextCache;
+
+// textures belong to the renderer that created them
+static std::unordered_map<SDL_Renderer *, TextCache> text_caches;
+
 spn_SDL_Texture *spnlib_sdl2_render_text(
 	SDL_Renderer *renderer,
+	Uint32 format,
 	const char *text,
 	TTF_Font *font,
+	SDL_Color color,
 	bool hq
 )
 {
@@ -150,10 +235,72 @@ spn_SDL_Texture *spnlib_sdl2_render_text(
 		TTF_RenderUTF8_Blended
 	};
 
-	SDL_Color color;
-	SDL_GetRenderDrawColor(renderer, &color.r, &color.g, &color.b, &color.a);
+	auto it = text_caches.find(renderer);
+	TextCache *cache = it != text_caches.end() && it->second.get_capacity() > 0
+	                 ? &it->second
+	                 : NULL;
+
+	TextKey key;
+
+	if (cache) {
+		key = {
+			font,
+			TTF_GetFontStyle(font),
+			Uint32(color.r) << 24 | Uint32(color.g) << 16 | Uint32(color.b) << 8 | color.a,
+			hq,
+			text
+		};
+
+		spn_SDL_Texture *cached = cache->lookup(key);
+		if (cached) {
+			spn_object_retain(cached);
+			return cached;
+		}
+	}
 
 	// Render text to surface, convert to texture
 	SDL_Surface *surface = renderers[hq](font, text, color);
-	return spnlib_SDL_texture_new_surface(renderer, surface);
+	spn_SDL_Texture *texture = spnlib_SDL_texture_new_surface(renderer, surface, format);
+
+	if (cache && texture->texture) {
+		std::size_t bytes = std::size_t(texture->width) * texture->height * SDL_BYTESPERPIXEL(format);
+		cache->insert(key, texture, bytes);
+	}
+
+	return texture;
+}
+
+void spnlib_sdl2_text_cache_set_capacity(SDL_Renderer *renderer, size_t bytes)
+{
+	text_caches[renderer].set_capacity(bytes);
+}
+
+void spnlib_sdl2_text_cache_purge(SDL_Renderer *renderer)
+{
+	auto it = text_caches.find(renderer);
+	if (it != text_caches.end()) {
+		it->second.purge();
+	}
+}
+
+SPN_SDL_TextCacheStats spnlib_sdl2_text_cache_stats(SDL_Renderer *renderer)
+{
+	SPN_SDL_TextCacheStats stats = { 0, 0, 0, 0, 0 };
+
+	auto it = text_caches.find(renderer);
+	if (it != text_caches.end()) {
+		const TextCache &cache = it->second;
+		stats.hits = cache.get_hits();
+		stats.misses = cache.get_misses();
+		stats.bytes = cache.get_size();
+		stats.count = cache.get_count();
+		stats.capacity = cache.get_capacity();
+	}
+
+	return stats;
+}
+
+void spnlib_sdl2_text_release_renderer(SDL_Renderer *renderer)
+{
+	text_caches.erase(renderer);
 }
@@ -19,17 +19,60 @@
 #include "sdl2_texture.h"
 
 
+// Returns the font 'name'.ttf of size 'ptsize' with 'style' applied.
+// Each font file is read only once; faces of different sizes are
+// opened from the same buffer. The fonts are owned by the library.
 SPN_API TTF_Font *spnlib_sdl2_get_font(
 	const char *name,
 	int ptsize,
 	const char *style
 );
 
+// Like spnlib_sdl2_get_font(), but leaves the style of the shared font
+// alone; the style mask is stored in 'stylemask' instead, to be set
+// only while rendering.
+SPN_API TTF_Font *spnlib_sdl2_get_font_unstyled(
+	const char *name,
+	int ptsize,
+	const char *style,
+	int *stylemask
+);
+
+// Loads a font ahead of time, so that spnlib_sdl2_get_font() doesn't
+// have to touch the disk later. Returns false if it can't be opened.
+SPN_API bool spnlib_sdl2_preload_font(const char *name, int ptsize);
+
+// Renders 'text' in 'color'. Text rendered in opaque white can be
+// drawn in any color using texture color and alpha modulation.
 SPN_API spn_SDL_Texture *spnlib_sdl2_render_text(
 	SDL_Renderer *renderer,
+	Uint32 format, // texture format, see spnlib_SDL_preferred_texture_format()
 	const char *text,
 	TTF_Font *font,
+	SDL_Color color,
 	bool hq // false: fast, true: high-quality
 );
 
+typedef struct SPN_SDL_TextCacheStats {
+	unsigned long hits;
+	unsigned long misses;
+	size_t bytes; // total size of the cached textures
+	size_t count; // number of cached textures
+	size_t capacity;
+} SPN_SDL_TextCacheStats;
+
+// Sets the maximal total size (in bytes) of the cached text textures
+// of 'renderer'. 0 (the default) disables caching. While caching is
+// enabled, spnlib_sdl2_render_text() returns a new reference to the
+// same texture object for the same text, font, style, color and quality.
+SPN_API void spnlib_sdl2_text_cache_set_capacity(SDL_Renderer *renderer, size_t bytes);
+
+// Drops every cached text texture of 'renderer'
+SPN_API void spnlib_sdl2_text_cache_purge(SDL_Renderer *renderer);
+
+SPN_API SPN_SDL_TextCacheStats spnlib_sdl2_text_cache_stats(SDL_Renderer *renderer);
+
+// Must be called before 'renderer' is destroyed
+SPN_API void spnlib_sdl2_text_release_renderer(SDL_Renderer *renderer);
+
 #endif // SPNLIB_SDL2_TTF_H
@@ -16,19 +16,33 @@
 #include "sdl2_timer.h"
 #include "sdl2_texture.h"
 #include "sdl2_image.h"
+#include "sdl2_assetpack.h"
 #include "sdl2_gradient.h"
-
-typedef struct spn_SDL_Window {
-	SpnObject base;
-	SDL_Window *window;
-	SDL_Renderer *renderer;
-	TTF_Font *font;
-} spn_SDL_Window;
+#include "sdl2_glyph.h"
+#include "sdl2_label.h"
+#include "sdl2_console.h"
+#include "sdl2_tiled.h"
 
 
 static void spn_SDL_Window_dtor(void *o)
 {
 	spn_SDL_Window *obj = o;
+
+	if (obj->paint.gradient) {
+		spn_object_release(obj->paint.gradient);
+	}
+
+	// the font doesn't retain the window while it's set (see sdl2_bmfont.h),
+	// and its page textures must be freed before the renderer is destroyed
+	if (obj->bitmap_font) {
+		spnlib_sdl2_bmfont_forget_window(obj->bitmap_font);
+		spn_object_release(obj->bitmap_font);
+	}
+
+	spnlib_sdl2_gradient_release_renderer(obj->renderer);
+	spnlib_sdl2_glyph_release_renderer(obj->renderer);
+	spnlib_sdl2_text_release_renderer(obj->renderer);
+	spnlib_sdl2_image_release_renderer(obj->renderer);
 	SDL_DestroyWindow(obj->window);
 	SDL_DestroyRenderer(obj->renderer);
 }
@@ -73,6 +87,9 @@ static SpnValue spn_SDL_Window_new(const char *title, int *width, int *height, U
 	);
 
 	obj->font = NULL;
+	obj->bitmap_font = NULL;
+	obj->paint.gradient = NULL;
+	obj->format = spnlib_SDL_preferred_texture_format(obj->renderer);
 
 	*ID = SDL_GetWindowID(obj->window);
 	return spn_makestrguserinfo(obj);
@@ -113,8 +130,6 @@ int spnlib_SDL_OpenWindow(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
 	return 0;
 }
 
-// Retrieves an internal window descriptor from
-// a "public" window object
 spn_SDL_Window *window_from_hashmap(SpnHashMap *hm)
 {
 	SpnValue objv = spn_hashmap_get_strkey(hm, "window");
@@ -328,18 +343,27 @@ static int spnlib_SDL_Window_getColor(SpnValue *ret, int argc, SpnValue *argv, v
 	return 0;
 }
 
+// the font retains the window again once it isn't the window's font
+static void unset_bitmap_font(spn_SDL_Window *window)
+{
+	if (window->bitmap_font) {
+		spnlib_sdl2_bmfont_retain_window(window->bitmap_font);
+		spn_object_release(window->bitmap_font);
+		window->bitmap_font = NULL;
+	}
+}
+
 // Parameters:
 // 0. window object
 // 1. font name (used to construct filename by appeding ".ttf")
 // 2. font size in points (72pt = 1 inch)
 // 3. font style string ("bold", "italic", "underline", "strikethrough", "normal"
 //    or any space-spearated combination thereof.)
+// Alternatively:
+// 1. a bitmap font loaded by loadBitmapFont()
 static int spnlib_SDL_Window_setFont(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
 {
 	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
-	CHECK_ARG_RETURN_ON_ERROR(1, string);
-	CHECK_ARG_RETURN_ON_ERROR(2, number);
-	CHECK_ARG_RETURN_ON_ERROR(3, string);
 
 	SpnHashMap *hm = HASHMAPARG(0);
 	spn_SDL_Window *window = window_from_hashmap(hm);
@@ -349,6 +373,39 @@ static int spnlib_SDL_Window_setFont(SpnValue *ret, int argc, SpnValue *argv, vo
 		return -1;
 	}
 
+	if (argc > 1 && spn_isstrguserinfo(&argv[1])) {
+		spn_SDL_BitmapFont *bitmap_font = OBJARG(1);
+
+		if (!spn_object_member_of_class(bitmap_font, &spn_SDL_BitmapFont_class)) {
+			spn_ctx_runtime_error(ctx, "2nd argument is not a valid bitmap font", NULL);
+			return -2;
+		}
+
+		// its page textures can only be drawn by the renderer that created them
+		if (spnlib_sdl2_bmfont_window(bitmap_font) != (SpnObject *)window) {
+			spn_ctx_runtime_error(ctx, "bitmap font was loaded by another window", NULL);
+			return -3;
+		}
+
+		if (bitmap_font != window->bitmap_font) {
+			unset_bitmap_font(window);
+
+			spn_object_retain(bitmap_font);
+			spnlib_sdl2_bmfont_release_window(bitmap_font);
+			window->bitmap_font = bitmap_font;
+		}
+
+		window->font = NULL;
+
+		return 0;
+	}
+
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+	CHECK_ARG_RETURN_ON_ERROR(3, string);
+
+	unset_bitmap_font(window);
+
 	const char *fontname = STRARG(1);
 	int ptsize = NUMARG(2);
 	const char *style = STRARG(3);
@@ -358,9 +415,55 @@ static int spnlib_SDL_Window_setFont(SpnValue *ret, int argc, SpnValue *argv, vo
 	return 0;
 }
 
+// Loads fonts in advance, so that setFont() is fast later.
+// Parameters:
+// 0. the window object
+// 1. an array of alternating font names and sizes:
+//    [ name1, ptsize1, name2, ptsize2, ... ]
+// Returns true if every font could be loaded.
+static int spnlib_SDL_Window_preloadFonts(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, array);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	SpnArray *fonts = ARRAYARG(1);
+	size_t n = spn_array_count(fonts);
+
+	if (n % 2 != 0) {
+		spn_ctx_runtime_error(ctx, "you must supply pairs of font names and sizes", NULL);
+		return -2;
+	}
+
+	bool success = true;
+
+	for (size_t i = 0; i < n; i += 2) {
+		SpnValue name = spn_array_get(fonts, i);
+		SpnValue ptsize = spn_array_get(fonts, i + 1);
+
+		if (!spn_isstring(&name) || !spn_isnumber(&ptsize)) {
+			spn_ctx_runtime_error(ctx, "font names must be strings and sizes must be numbers", NULL);
+			return -3;
+		}
+
+		SpnString *str = spn_stringvalue(&name);
+		success &= spnlib_sdl2_preload_font(str->cstr, spn_intvalue_f(&ptsize));
+	}
+
+	*ret = spn_makebool(success);
+	return 0;
+}
+
 // Draw a rectangle with coordinates (x, y) and size (w, h).
-// if 'fill' is nonzero, fill it with the drawing color,
-// otherwise draw the contours only.
+// if 'fill' is nonzero, fill it with the drawing color (or with
+// the fill gradient, if any), otherwise draw the contours only.
 static int spnlib_SDL_Window_drawRect(
 	SpnValue *ret,
 	int argc,
@@ -385,7 +488,9 @@ static int spnlib_SDL_Window_drawRect(
 
 	SDL_Renderer *renderer = window->renderer;
 
-	if (fill) {
+	if (fill && window->paint.gradient) {
+		spnlib_sdl2_paint_rect(renderer, window->format, &window->paint, NUMARG(1), NUMARG(2), NUMARG(3), NUMARG(4));
+	} else if (fill) {
 		SDL_RenderFillRect(renderer, &(SDL_Rect){ NUMARG(1), NUMARG(2), NUMARG(3), NUMARG(4) });
 	} else {
 		SDL_RenderDrawRect(renderer, &(SDL_Rect){ NUMARG(1), NUMARG(2), NUMARG(3), NUMARG(4) });
@@ -512,7 +617,9 @@ static int spnlib_SDL_Window_drawEllipse(
 	Uint8 R, G, B, A;
 	SDL_GetRenderDrawColor(renderer, &R, &G, &B, &A);
 
-	if (fill) {
+	if (fill && window->paint.gradient) {
+		spnlib_sdl2_paint_ellipse(renderer, window->format, &window->paint, x, y, rx, ry);
+	} else if (fill) {
 		filledEllipseRGBA(renderer, x, y, rx, ry, R, G, B, A);
 	} else {
 		ellipseRGBA(renderer, x, y, rx, ry, R, G, B, A);
@@ -578,6 +685,11 @@ static int spnlib_SDL_Window_fillPolygon(SpnValue *ret, int argc, SpnValue *argv
 		vy[i >> 1] = spn_intvalue_f(&y);
 	}
 
+	if (window->paint.gradient) {
+		spnlib_sdl2_paint_polygon(renderer, window->format, &window->paint, vx, vy, npoints);
+		return 0;
+	}
+
 	Uint8 R, G, B, A;
 	SDL_GetRenderDrawColor(renderer, &R, &G, &B, &A);
 
@@ -623,7 +735,10 @@ static int spnlib_SDL_Window_drawRoundedRect(
 	Uint8 R, G, B, A;
 	SDL_GetRenderDrawColor(renderer, &R, &G, &B, &A);
 
-	if (fill) {
+	if (fill && window->paint.gradient) {
+		// roundedBoxRGBA() includes both (x, y) and (x + w, y + h)
+		spnlib_sdl2_paint_rounded_rect(renderer, window->format, &window->paint, x, y, w + 1, h + 1, r);
+	} else if (fill) {
 		roundedBoxRGBA(renderer, x, y, x + w, y + h, r, R, G, B, A);
 	} else {
 		roundedRectangleRGBA(renderer, x, y, x + w, y + h, r, R, G, B, A);
@@ -759,6 +874,12 @@ static int spnlib_SDL_Window_point(SpnValue *ret, int argc, SpnValue *argv, void
 
 // Draw 'text' with the current font,
 // return a texture containing the result.
+// Parameters:
+// 0. the window object
+// 1. the text, as a string
+// 2. boolean, false: fast, true: high-quality
+// 3. (optional) boolean, true: render in white instead of the current
+//    color, so that the texture can be tinted by renderTexture()
 static int spnlib_SDL_Window_renderText(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
 {
 	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
@@ -774,7 +895,10 @@ static int spnlib_SDL_Window_renderText(SpnValue *ret, int argc, SpnValue *argv,
 	}
 
 	if (window->font == NULL) {
-		spn_ctx_runtime_error(ctx, "no font set; call setFont() first", NULL);
+		const char *msg = window->bitmap_font
+		                ? "renderText() needs a TrueType font, not a bitmap font"
+		                : "no font set; call setFont() first";
+		spn_ctx_runtime_error(ctx, msg, NULL);
 		return -2;
 	}
 
@@ -782,11 +906,25 @@ static int spnlib_SDL_Window_renderText(SpnValue *ret, int argc, SpnValue *argv,
 
 	const char *text = STRARG(1);
 	bool hq = BOOLARG(2);
+	bool white = false;
+
+	if (argc > 3) {
+		CHECK_ARG_RETURN_ON_ERROR(3, bool);
+		white = BOOLARG(3);
+	}
+
+	SDL_Color color = { 255, 255, 255, 255 };
+
+	if (!white) {
+		SDL_GetRenderDrawColor(renderer, &color.r, &color.g, &color.b, &color.a);
+	}
 
 	spn_SDL_Texture *texture = spnlib_sdl2_render_text(
 		renderer,
+		window->format,
 		text,
 		window->font,
+		color,
 		hq
 	);
 
@@ -794,6 +932,109 @@ static int spnlib_SDL_Window_renderText(SpnValue *ret, int argc, SpnValue *argv,
 	return 0;
 }
 
+// Enables caching of textures created by renderText().
+// Parameters:
+// 0. the window object
+// 1. maximal total size of cached textures in bytes (0 disables caching)
+static int spnlib_SDL_Window_setTextCacheSize(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	double bytes = NUMARG(1);
+	spnlib_sdl2_text_cache_set_capacity(window->renderer, bytes > 0 ? bytes : 0);
+
+	return 0;
+}
+
+// Returns the statistics of the text texture cache as a hashmap:
+// { hits, misses, hitRate, bytes, count, capacity }
+static int spnlib_SDL_Window_textCacheStats(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	SPN_SDL_TextCacheStats stats = spnlib_sdl2_text_cache_stats(window->renderer);
+	unsigned long lookups = stats.hits + stats.misses;
+
+	*ret = spn_makehashmap();
+	SpnHashMap *result = spn_hashmapvalue(ret);
+
+	set_integer_property(result, "hits", stats.hits);
+	set_integer_property(result, "misses", stats.misses);
+	set_float_property(result, "hitRate", lookups ? (double)stats.hits / lookups : 0.0);
+	set_integer_property(result, "bytes", stats.bytes);
+	set_integer_property(result, "count", stats.count);
+	set_integer_property(result, "capacity", stats.capacity);
+
+	return 0;
+}
+
+// Draw 'text' with the current font and drawing color at (x, y),
+// without creating any textures (glyphs are cached in an atlas).
+// Parameters:
+// 0. the window object
+// 1. X coordinate of the top left corner of the text
+// 2. Y coordinate of the top left corner of the text
+// 3. the text to draw, as a string
+static int spnlib_SDL_Window_drawText(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, number); // x
+	CHECK_ARG_RETURN_ON_ERROR(2, number); // y
+	CHECK_ARG_RETURN_ON_ERROR(3, string); // text
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	if (window->font == NULL && window->bitmap_font == NULL) {
+		spn_ctx_runtime_error(ctx, "no font set; call setFont() first", NULL);
+		return -2;
+	}
+
+	SDL_Renderer *renderer = window->renderer;
+
+	SDL_Color color;
+	SDL_GetRenderDrawColor(renderer, &color.r, &color.g, &color.b, &color.a);
+
+	if (window->bitmap_font) {
+		spnlib_sdl2_bmfont_draw_text(window->bitmap_font, NUMARG(1), NUMARG(2), STRARG(3), color);
+		return 0;
+	}
+
+	spnlib_sdl2_draw_text(
+		renderer,
+		window->format,
+		window->font,
+		NUMARG(1),
+		NUMARG(2),
+		STRARG(3),
+		color
+	);
+
+	return 0;
+}
+
 // parameters:
 // 0. the window object
 // 1. the text to render, as a string
@@ -810,7 +1051,7 @@ static int spnlib_SDL_Window_textSize(SpnValue *ret, int argc, SpnValue *argv, v
 		return -1;
 	}
 
-	if (window->font == NULL) {
+	if (window->font == NULL && window->bitmap_font == NULL) {
 		spn_ctx_runtime_error(ctx, "no font set; call setFont() first", NULL);
 		return -2;
 	}
@@ -818,7 +1059,13 @@ static int spnlib_SDL_Window_textSize(SpnValue *ret, int argc, SpnValue *argv, v
 	const char *text = STRARG(1);
 
 	int w, h;
-	TTF_SizeUTF8(window->font, text, &w, &h);
+
+	if (window->bitmap_font) {
+		w = spnlib_sdl2_bmfont_text_width(window->bitmap_font, text);
+		h = spnlib_sdl2_bmfont_text_box_size(window->bitmap_font, text, 0, 0).height;
+	} else {
+		TTF_SizeUTF8(window->font, text, &w, &h);
+	}
 
 	*ret = spn_makehashmap();
 	SpnHashMap *size = spn_hashmapvalue(ret);
@@ -832,18 +1079,15 @@ static int spnlib_SDL_Window_textSize(SpnValue *ret, int argc, SpnValue *argv, v
 	return 0;
 }
 
-// Render texture in the given window
+// Measures many strings at once, without creating a hashmap for each.
 // Parameters:
 // 0. the window object
-// 1. the texture to render
-// 2. X coordinate of the point to render at
-// 3. Y coordinate of the point to render at
-static int spnlib_SDL_Window_renderTexture(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+// 1. array of strings
+// Returns an array of the widths of the strings, in the same order.
+static int spnlib_SDL_Window_measureTexts(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
 {
 	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
-	CHECK_ARG_RETURN_ON_ERROR(1, strguserinfo);
-	CHECK_ARG_RETURN_ON_ERROR(2, number);
-	CHECK_ARG_RETURN_ON_ERROR(3, number);
+	CHECK_ARG_RETURN_ON_ERROR(1, array);
 
 	SpnHashMap *hm = HASHMAPARG(0);
 	spn_SDL_Window *window = window_from_hashmap(hm);
@@ -853,36 +1097,73 @@ static int spnlib_SDL_Window_renderTexture(SpnValue *ret, int argc, SpnValue *ar
 		return -1;
 	}
 
-	spn_SDL_Texture *texture = OBJARG(1);
-	if (!spn_object_member_of_class(texture, &spn_SDL_Texture_class)) {
-		spn_ctx_runtime_error(ctx, "2nd argument is not a valid texture", NULL);
+	if (window->font == NULL && window->bitmap_font == NULL) {
+		spn_ctx_runtime_error(ctx, "no font set; call setFont() first", NULL);
 		return -2;
 	}
 
-	int x = NUMARG(2);
-	int y = NUMARG(3);
+	SpnArray *texts = ARRAYARG(1);
+	size_t n = spn_array_count(texts);
 
-	int w, h;
-	SDL_QueryTexture(texture->texture, NULL, NULL, &w, &h);
+	for (size_t i = 0; i < n; i++) {
+		SpnValue text = spn_array_get(texts, i);
 
-	SDL_RenderCopy(
-		window->renderer,
-		texture->texture,
-		NULL,
-		&(SDL_Rect){ x, y, w, h }
-	);
+		if (!spn_isstring(&text)) {
+			spn_ctx_runtime_error(ctx, "texts must be strings", NULL);
+			return -3;
+		}
+	}
+
+	*ret = spn_makearray();
+	SpnArray *widths = spn_arrayvalue(ret);
+
+	for (size_t i = 0; i < n; i++) {
+		SpnValue text = spn_array_get(texts, i);
+		SpnString *str = spn_stringvalue(&text);
+		SpnValue width = spn_makeint(
+			window->bitmap_font
+			  ? spnlib_sdl2_bmfont_text_width(window->bitmap_font, str->cstr)
+			  : spnlib_sdl2_text_width(window->font, str->cstr)
+		);
+		spn_array_push(widths, &width);
+	}
 
 	return 0;
 }
 
-// Parses an image file and loads it into a texture object.
+static SPN_SDL_TextAlign get_text_align_value(const char *name)
+{
+	static const struct {
+		const char *name;
+		SPN_SDL_TextAlign align;
+	} aligns[] = {
+		{ "left",   SPN_SDL_ALIGN_LEFT   },
+		{ "center", SPN_SDL_ALIGN_CENTER },
+		{ "right",  SPN_SDL_ALIGN_RIGHT  }
+	};
+
+	for (size_t i = 0; i < COUNT(aligns); i++) {
+		if (strcmp(aligns[i].name, name) == 0) {
+			return aligns[i].align;
+		}
+	}
+
+	// default to left
+	return SPN_SDL_ALIGN_LEFT;
+}
+
+// Size of a block of text as laid out by drawTextBox()
 // Parameters:
 // 0. the window object
-// 1. the filename as a string
-static int spnlib_SDL_Window_loadImage(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+// 1. the text, as a string
+// 2. maximal width of a line (0: only break at newline characters)
+// 3. (optional) distance between lines; defaults to the line skip of the font
+// Returns a hashmap: { width, height, lines }
+static int spnlib_SDL_Window_textBoxSize(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
 {
 	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
 	CHECK_ARG_RETURN_ON_ERROR(1, string);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
 
 	SpnHashMap *hm = HASHMAPARG(0);
 	spn_SDL_Window *window = window_from_hashmap(hm);
@@ -892,30 +1173,48 @@ static int spnlib_SDL_Window_loadImage(SpnValue *ret, int argc, SpnValue *argv,
 		return -1;
 	}
 
-	const char *filename = STRARG(1);
-	spn_SDL_Texture *texture = spnlib_sdl2_load_image(window->renderer, filename);
+	if (window->font == NULL && window->bitmap_font == NULL) {
+		spn_ctx_runtime_error(ctx, "no font set; call setFont() first", NULL);
+		return -2;
+	}
 
-	// return the loaded image if loading succeeded.
-	// otherwise, implicitly return nil.
-	if (texture) {
-		*ret = spn_makestrguserinfo(texture);
+	int line_height = 0;
+	if (argc > 3) {
+		CHECK_ARG_RETURN_ON_ERROR(3, number);
+		line_height = NUMARG(3);
 	}
 
+	SPN_SDL_TextBoxSize box = window->bitmap_font
+	  ? spnlib_sdl2_bmfont_text_box_size(window->bitmap_font, STRARG(1), NUMARG(2), line_height)
+	  : spnlib_sdl2_text_box_size(window->font, STRARG(1), NUMARG(2), line_height);
+
+	*ret = spn_makehashmap();
+	SpnHashMap *size = spn_hashmapvalue(ret);
+
+	set_integer_property(size, "width", box.width);
+	set_integer_property(size, "height", box.height);
+	set_integer_property(size, "lines", box.lines);
+
 	return 0;
 }
 
-/////////////////////////////////
-//////      GRADIENTS      //////
-/////////////////////////////////
-
-static int spnlib_SDL_Window_linearGradient(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+// Draw a block of text, wrapped to a given width, with the current
+// font and drawing color (glyphs are cached in an atlas, see drawText()).
+// Parameters:
+// 0. the window object
+// 1. X coordinate of the top left corner of the box
+// 2. Y coordinate of the top left corner of the box
+// 3. the text to draw, as a string
+// 4. maximal width of a line (0: only break at newline characters)
+// 5. (optional) alignment: "left" (default), "center" or "right"
+// 6. (optional) distance between lines; defaults to the line skip of the font
+static int spnlib_SDL_Window_drawTextBox(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
 {
-	CHECK_ARG_RETURN_ON_ERROR(0, hashmap); // window
-	CHECK_ARG_RETURN_ON_ERROR(1, number);  // w
-	CHECK_ARG_RETURN_ON_ERROR(2, number);  // h
-	CHECK_ARG_RETURN_ON_ERROR(3, number);  // delta x (for computing slope)
-	CHECK_ARG_RETURN_ON_ERROR(4, number);  // delta y        - " -
-	CHECK_ARG_RETURN_ON_ERROR(5, array);   // color-stops
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, number); // x
+	CHECK_ARG_RETURN_ON_ERROR(2, number); // y
+	CHECK_ARG_RETURN_ON_ERROR(3, string); // text
+	CHECK_ARG_RETURN_ON_ERROR(4, number); // wrap width
 
 	SpnHashMap *hm = HASHMAPARG(0);
 	spn_SDL_Window *window = window_from_hashmap(hm);
@@ -925,96 +1224,822 @@ static int spnlib_SDL_Window_linearGradient(SpnValue *ret, int argc, SpnValue *a
 		return -1;
 	}
 
-	int w = NUMARG(1);
-	int h = NUMARG(2);
-	double dx = NUMARG(3);
-	double dy = NUMARG(4);
+	if (window->font == NULL && window->bitmap_font == NULL) {
+		spn_ctx_runtime_error(ctx, "no font set; call setFont() first", NULL);
+		return -2;
+	}
 
-	SpnArray *arr = ARRAYARG(5);
-	size_t n_stops = spn_array_count(arr);
-	SPN_SDL_ColorStop color_stops[n_stops];
-	bool success = spnlib_sdl2_array_to_colorstop(arr, color_stops);
+	SPN_SDL_TextAlign align = SPN_SDL_ALIGN_LEFT;
+	if (argc > 5) {
+		CHECK_ARG_RETURN_ON_ERROR(5, string);
+		align = get_text_align_value(STRARG(5));
+	}
 
-	if (!success) {
-		spn_ctx_runtime_error(ctx, "invalid color stop specification", NULL);
-		return -2;
+	int line_height = 0;
+	if (argc > 6) {
+		CHECK_ARG_RETURN_ON_ERROR(6, number);
+		line_height = NUMARG(6);
 	}
 
-	SDL_Texture *texture = spnlib_sdl2_linear_gradient(
-		window->renderer,
-		w,
-		h,
-		dx,
-		dy,
-		color_stops,
-		n_stops
-	);
+	SDL_Renderer *renderer = window->renderer;
 
-	if (texture == NULL) {
-		spn_ctx_runtime_error(ctx, "invalid dimensions or bad number of color stops", NULL);
-		return -3;
+	SDL_Color color;
+	SDL_GetRenderDrawColor(renderer, &color.r, &color.g, &color.b, &color.a);
+
+	if (window->bitmap_font) {
+		spnlib_sdl2_bmfont_draw_text_box(
+			window->bitmap_font,
+			NUMARG(1),
+			NUMARG(2),
+			STRARG(3),
+			NUMARG(4),
+			align,
+			line_height,
+			color
+		);
+
+		return 0;
 	}
 
-	spn_SDL_Texture *obj = spnlib_SDL_texture_new(texture);
-	*ret = spn_makestrguserinfo(obj);
+	spnlib_sdl2_draw_text_box(
+		renderer,
+		window->format,
+		window->font,
+		NUMARG(1),
+		NUMARG(2),
+		STRARG(3),
+		NUMARG(4),
+		align,
+		line_height,
+		color
+	);
+
 	return 0;
 }
 
-static int spnlib_SDL_Window_ellipsoidalGradient(
-	SpnValue *ret,
-	int argc,
-	SpnValue *argv,
-	void *ctx,
-	SDL_Texture *(*gradientPainter)(
-		SDL_Renderer *renderer,
-		int rx,
-		int ry,
-		const SPN_SDL_ColorStop color_stops[],
-		unsigned n
-	)
-)
-{
-	CHECK_ARG_RETURN_ON_ERROR(0, hashmap); // window
-	CHECK_ARG_RETURN_ON_ERROR(1, number);  // rx
-	CHECK_ARG_RETURN_ON_ERROR(2, number);  // ry
-	CHECK_ARG_RETURN_ON_ERROR(3, array);   // color-stops
-
-	SpnHashMap *hm = HASHMAPARG(0);
-	spn_SDL_Window *window = window_from_hashmap(hm);
+// How a single renderTexture() call modulates and blends the texture
+typedef struct TextureStyle {
+	Uint8 r, g, b, a;
+	SDL_BlendMode blend;
+	bool has_blend; // otherwise the blend mode of the texture is used
+} TextureStyle;
 
-	if (window == NULL) {
-		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
-		return -1;
-	}
+// Reads the style argument of renderTexture(). Missing keys keep their
+// default values; returns false if any of them has the wrong type.
+static bool get_texture_style(SpnHashMap *hm, TextureStyle *style)
+{
+	static const char *const keys[] = { "r", "g", "b", "a" };
+	Uint8 *components[] = { &style->r, &style->g, &style->b, &style->a };
 
-	int rx = NUMARG(1);
-	int ry = NUMARG(2);
+	*style = (TextureStyle){ 255, 255, 255, 255, SDL_BLENDMODE_NONE, false };
 
-	SpnArray *arr = ARRAYARG(3);
-	size_t n_stops = spn_array_count(arr);
-	SPN_SDL_ColorStop color_stops[n_stops];
-	bool success = spnlib_sdl2_array_to_colorstop(arr, color_stops);
+	for (size_t i = 0; i < COUNT(keys); i++) {
+		SpnValue value = spn_hashmap_get_strkey(hm, keys[i]);
 
-	if (!success) {
-		spn_ctx_runtime_error(ctx, "invalid color stop specification", NULL);
-		return -2;
+		if (spn_isnumber(&value)) {
+			*components[i] = constrain_to_01(spn_floatvalue_f(&value)) * 255;
+		} else if (!spn_isnil(&value)) {
+			return false;
+		}
 	}
 
-	SDL_Texture *texture = gradientPainter(
-		window->renderer,
-		rx,
-		ry,
-		color_stops,
-		n_stops
-	);
+	SpnValue blend = spn_hashmap_get_strkey(hm, "blend");
 
-	if (texture == NULL) {
-		spn_ctx_runtime_error(ctx, "invalid dimensions or bad number of color stops", NULL);
-		return -3;
+	if (spn_isstring(&blend)) {
+		style->blend = get_blend_mode_value(spn_stringvalue(&blend)->cstr);
+		style->has_blend = true;
+	} else if (!spn_isnil(&blend)) {
+		return false;
 	}
 
-	spn_SDL_Texture *obj = spnlib_SDL_texture_new(texture);
-	*ret = spn_makestrguserinfo(obj);
+	return true;
+}
+
+// Render texture in the given window
+// Parameters:
+// 0. the window object
+// 1. the texture to render
+// 2. X coordinate of the point to render at
+// 3. Y coordinate of the point to render at
+// 4. (optional) width to stretch the texture to
+// 5. (optional) height to stretch the texture to
+// last. (optional) hashmap with the color ("r", "g", "b") and opacity
+//    ("a") to modulate the texture by, and the blend mode ("blend");
+//    they only apply to this call, not to the texture itself
+static int spnlib_SDL_Window_renderTexture(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, strguserinfo);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+	CHECK_ARG_RETURN_ON_ERROR(3, number);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	spn_SDL_Texture *texture = OBJARG(1);
+	if (!spn_object_member_of_class(texture, &spn_SDL_Texture_class)) {
+		spn_ctx_runtime_error(ctx, "2nd argument is not a valid texture", NULL);
+		return -2;
+	}
+
+	int x = NUMARG(2);
+	int y = NUMARG(3);
+
+	// stretch to the optional size, or to the logical size of the texture
+	int w = texture->width;
+	int h = texture->height;
+
+	if (argc >= 6 && spn_isnumber(&argv[4]) && spn_isnumber(&argv[5])) {
+		w = NUMARG(4);
+		h = NUMARG(5);
+	}
+
+	bool has_style = argc > 4 && spn_ishashmap(&argv[argc - 1]);
+	TextureStyle style;
+
+	if (has_style && !get_texture_style(HASHMAPARG(argc - 1), &style)) {
+		spn_ctx_runtime_error(ctx, "invalid texture style", NULL);
+		return -3;
+	}
+
+	// draw minified images from the closest mip level
+	spn_SDL_Texture *level = spnlib_SDL_texture_level_for_size(texture, w, h);
+
+	// e. g. the texture of empty text
+	if (level->texture == NULL) {
+		return 0;
+	}
+
+	// Cached textures are shared, so the style is
+	// only applied for the duration of this call
+	Uint8 old_r, old_g, old_b, old_a;
+	SDL_BlendMode old_blend;
+
+	if (has_style) {
+		SDL_GetTextureColorMod(level->texture, &old_r, &old_g, &old_b);
+		SDL_GetTextureAlphaMod(level->texture, &old_a);
+		SDL_GetTextureBlendMode(level->texture, &old_blend);
+
+		SDL_SetTextureColorMod(level->texture, style.r, style.g, style.b);
+		SDL_SetTextureAlphaMod(level->texture, style.a);
+
+		if (style.has_blend) {
+			SDL_SetTextureBlendMode(level->texture, style.blend);
+		}
+	}
+
+	SDL_RenderCopy(
+		window->renderer,
+		level->texture,
+		NULL,
+		&(SDL_Rect){ x, y, w, h }
+	);
+
+	if (has_style) {
+		SDL_SetTextureColorMod(level->texture, old_r, old_g, old_b);
+		SDL_SetTextureAlphaMod(level->texture, old_a);
+		SDL_SetTextureBlendMode(level->texture, old_blend);
+	}
+
+	return 0;
+}
+
+// Multiplies the color of the texture by the given color when it's
+// rendered. The modulation is a property of the texture: it applies to
+// every subsequent renderTexture() call until it is changed, by every
+// holder of the texture (cached textures are shared). Prefer the style
+// argument of renderTexture() for tinting a single draw.
+// Parameters:
+// 0. the window object
+// 1. the texture
+// 2...4. red, green and blue components in [0...1]
+static int spnlib_SDL_Window_setTextureColorMod(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, strguserinfo);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+	CHECK_ARG_RETURN_ON_ERROR(3, number);
+	CHECK_ARG_RETURN_ON_ERROR(4, number);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	spn_SDL_Texture *texture = OBJARG(1);
+	if (!spn_object_member_of_class(texture, &spn_SDL_Texture_class)) {
+		spn_ctx_runtime_error(ctx, "2nd argument is not a valid texture", NULL);
+		return -2;
+	}
+
+	double r = constrain_to_01(NUMARG(2));
+	double g = constrain_to_01(NUMARG(3));
+	double b = constrain_to_01(NUMARG(4));
+
+	// every mip level is modulated alike; levels without a texture
+	// (e. g. the texture of empty text) are skipped
+	for (spn_SDL_Texture *level = texture; level; level = level->mip) {
+		if (level->texture) {
+			SDL_SetTextureColorMod(level->texture, r * 255, g * 255, b * 255);
+		}
+	}
+
+	return 0;
+}
+
+// Multiplies the alpha channel of the texture by the given value
+// when it's rendered. See setTextureColorMod().
+// Parameters:
+// 0. the window object
+// 1. the texture
+// 2. opacity in [0...1]
+static int spnlib_SDL_Window_setTextureAlphaMod(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, strguserinfo);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	spn_SDL_Texture *texture = OBJARG(1);
+	if (!spn_object_member_of_class(texture, &spn_SDL_Texture_class)) {
+		spn_ctx_runtime_error(ctx, "2nd argument is not a valid texture", NULL);
+		return -2;
+	}
+
+	double a = constrain_to_01(NUMARG(2));
+
+	for (spn_SDL_Texture *level = texture; level; level = level->mip) {
+		if (level->texture) {
+			SDL_SetTextureAlphaMod(level->texture, a * 255);
+		}
+	}
+
+	return 0;
+}
+
+// Sets the blend mode used when rendering the texture,
+// by every holder of it. See setTextureColorMod().
+// Parameters:
+// 0. the window object
+// 1. the texture
+// 2. blend mode name, same as for setBlendMode()
+static int spnlib_SDL_Window_setTextureBlendMode(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, strguserinfo);
+	CHECK_ARG_RETURN_ON_ERROR(2, string);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	spn_SDL_Texture *texture = OBJARG(1);
+	if (!spn_object_member_of_class(texture, &spn_SDL_Texture_class)) {
+		spn_ctx_runtime_error(ctx, "2nd argument is not a valid texture", NULL);
+		return -2;
+	}
+
+	SDL_BlendMode mode = get_blend_mode_value(STRARG(2));
+
+	for (spn_SDL_Texture *level = texture; level; level = level->mip) {
+		if (level->texture) {
+			SDL_SetTextureBlendMode(level->texture, mode);
+		}
+	}
+
+	return 0;
+}
+
+// Reads the options of loadImage(). Missing keys keep their default
+// values; returns false if any of them has the wrong type.
+static bool get_image_options(SpnHashMap *hm, SPN_SDL_ImageOptions *options)
+{
+	SpnValue max_width = spn_hashmap_get_strkey(hm, "maxWidth");
+	SpnValue max_height = spn_hashmap_get_strkey(hm, "maxHeight");
+	SpnValue mipmaps = spn_hashmap_get_strkey(hm, "mipmaps");
+	SpnValue format = spn_hashmap_get_strkey(hm, "format");
+
+	*options = (SPN_SDL_ImageOptions){ 0, 0, false, SDL_PIXELFORMAT_UNKNOWN };
+
+	if (spn_isnumber(&max_width)) {
+		options->max_width = spn_floatvalue_f(&max_width);
+	} else if (!spn_isnil(&max_width)) {
+		return false;
+	}
+
+	if (spn_isnumber(&max_height)) {
+		options->max_height = spn_floatvalue_f(&max_height);
+	} else if (!spn_isnil(&max_height)) {
+		return false;
+	}
+
+	if (spn_isbool(&mipmaps)) {
+		options->mipmaps = spn_boolvalue(&mipmaps);
+	} else if (!spn_isnil(&mipmaps)) {
+		return false;
+	}
+
+	if (spn_isstring(&format)) {
+		const char *name = spn_stringvalue(&format)->cstr;
+
+		if (strcmp(name, "RGB565") == 0) {
+			options->format = SDL_PIXELFORMAT_RGB565;
+		} else if (strcmp(name, "ARGB4444") == 0) {
+			options->format = SDL_PIXELFORMAT_ARGB4444;
+		} else if (strcmp(name, "default") != 0) {
+			return false;
+		}
+	} else if (!spn_isnil(&format)) {
+		return false;
+	}
+
+	return true;
+}
+
+// Parses an image file and loads it into a texture object.
+// Parameters:
+// 0. the window object
+// 1. the filename as a string
+// 2. (optional) a hashmap of options: "maxWidth", "maxHeight",
+//    "mipmaps" and "format"
+static int spnlib_SDL_Window_loadImage(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	SPN_SDL_ImageOptions options;
+	bool has_options = argc > 2;
+
+	if (has_options) {
+		CHECK_ARG_RETURN_ON_ERROR(2, hashmap);
+
+		if (!get_image_options(HASHMAPARG(2), &options)) {
+			spn_ctx_runtime_error(ctx, "invalid image options", NULL);
+			return -2;
+		}
+	}
+
+	const char *filename = STRARG(1);
+	spn_SDL_Texture *texture = spnlib_sdl2_load_image_with_options(
+		window->renderer,
+		window->format,
+		filename,
+		has_options ? &options : NULL
+	);
+
+	// return the loaded image if loading succeeded.
+	// otherwise, implicitly return nil.
+	if (texture) {
+		*ret = spn_makestrguserinfo(texture);
+	}
+
+	return 0;
+}
+
+// Decodes an image from the contents of a string.
+// Parameters:
+// 0. the window object
+// 1. the encoded image (e. g. the contents of a PNG file) as a string
+// 2. (optional) the format of the image as a file extension, e. g. "png"
+static int spnlib_SDL_Window_loadImageFromBuffer(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	const char *type = NULL;
+	if (argc > 2) {
+		CHECK_ARG_RETURN_ON_ERROR(2, string);
+		type = STRARG(2);
+	}
+
+	spn_SDL_Texture *texture = spnlib_sdl2_load_image_from_memory(
+		window->renderer,
+		window->format,
+		STRARG(1),
+		STRLENARG(1),
+		type
+	);
+
+	if (texture) {
+		*ret = spn_makestrguserinfo(texture);
+	}
+
+	return 0;
+}
+
+// Same as loadImage(), but the file is memory-mapped instead of read.
+// Parameters:
+// 0. the window object
+// 1. the filename as a string
+static int spnlib_SDL_Window_loadImageMapped(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	spn_SDL_Texture *texture = spnlib_sdl2_load_image_mapped(window->renderer, window->format, STRARG(1));
+
+	if (texture) {
+		*ret = spn_makestrguserinfo(texture);
+	}
+
+	return 0;
+}
+
+// Creates a texture from an image of an asset pack
+// Parameters:
+// 0. the window object
+// 1. the asset pack, as returned by SDL::OpenAssetPack()
+// 2. the name of the image within the pack
+static int spnlib_SDL_Window_loadPackedImage(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, strguserinfo);
+	CHECK_ARG_RETURN_ON_ERROR(2, string);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	void *pack = OBJARG(1);
+
+	if (!spn_object_member_of_class(pack, &spn_SDL_AssetPack_class)) {
+		spn_ctx_runtime_error(ctx, "2nd argument is not a valid asset pack", NULL);
+		return -2;
+	}
+
+	spn_SDL_Texture *texture = spnlib_sdl2_assetpack_load(window->renderer, pack, STRARG(2));
+
+	if (texture) {
+		*ret = spn_makestrguserinfo(texture);
+	}
+
+	return 0;
+}
+
+// Returns the name of the texture format the renderer prefers, which
+// images are converted to when loaded, e. g. "SDL_PIXELFORMAT_ARGB8888"
+static int spnlib_SDL_Window_pixelFormat(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	*ret = spn_makestring_nocopy(SDL_GetPixelFormatName(window->format));
+	return 0;
+}
+
+// Starts loading an image in the background. When it's done, an event
+// of type "imageloaded" is delivered, with the loaded image in it.
+// Parameters:
+// 0. the window object
+// 1. the filename as a string
+// Returns the ID of the request, which the event will also contain.
+static int spnlib_SDL_Window_loadImageAsync(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	// the window is kept alive, so that its renderer is still
+	// there when the texture is created
+	Uint32 id = spnlib_sdl2_load_image_async(
+		window->renderer,
+		window->format,
+		STRARG(1),
+		&window->base
+	);
+
+	*ret = spn_makeint(id);
+
+	return 0;
+}
+
+// Enables caching of images loaded by loadImage().
+// Parameters:
+// 0. the window object
+// 1. maximal total size of cached images in bytes (0 disables caching)
+static int spnlib_SDL_Window_setImageCacheSize(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	double bytes = NUMARG(1);
+	spnlib_sdl2_image_cache_set_capacity(window->renderer, bytes > 0 ? bytes : 0);
+
+	return 0;
+}
+
+static int spnlib_SDL_Window_purgeImageCache(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	spnlib_sdl2_image_cache_purge(window->renderer);
+
+	return 0;
+}
+
+// Returns the statistics of the image cache as a hashmap:
+// { hits, misses, hitRate, bytes, count, capacity }
+static int spnlib_SDL_Window_imageCacheStats(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	SPN_SDL_ImageCacheStats stats = spnlib_sdl2_image_cache_stats(window->renderer);
+	unsigned long lookups = stats.hits + stats.misses;
+
+	*ret = spn_makehashmap();
+	SpnHashMap *result = spn_hashmapvalue(ret);
+
+	set_integer_property(result, "hits", stats.hits);
+	set_integer_property(result, "misses", stats.misses);
+	set_float_property(result, "hitRate", lookups ? (double)stats.hits / lookups : 0.0);
+	set_integer_property(result, "bytes", stats.bytes);
+	set_integer_property(result, "count", stats.count);
+	set_integer_property(result, "capacity", stats.capacity);
+
+	return 0;
+}
+
+// Loads a bitmap font, which can be passed to setFont().
+// Parameters:
+// 0. the window object
+// 1. the filename of the BMFont descriptor (.fnt) as a string
+static int spnlib_SDL_Window_loadBitmapFont(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, string);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	spn_SDL_BitmapFont *font = spnlib_sdl2_bmfont_load(
+		(SpnObject *)window,
+		window->renderer,
+		window->format,
+		STRARG(1)
+	);
+
+	// return nil if the font can't be loaded
+	if (font) {
+		*ret = spn_makestrguserinfo(font);
+	}
+
+	return 0;
+}
+
+/////////////////////////////////
+//////      GRADIENTS      //////
+/////////////////////////////////
+
+static int spnlib_SDL_Window_linearGradient(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap); // window
+	CHECK_ARG_RETURN_ON_ERROR(1, number);  // w
+	CHECK_ARG_RETURN_ON_ERROR(2, number);  // h
+	CHECK_ARG_RETURN_ON_ERROR(3, number);  // delta x (for computing slope)
+	CHECK_ARG_RETURN_ON_ERROR(4, number);  // delta y        - " -
+	                                       // 5: color-stops or Gradient object
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	int w = NUMARG(1);
+	int h = NUMARG(2);
+	double dx = NUMARG(3);
+	double dy = NUMARG(4);
+
+	spn_SDL_Texture *texture;
+
+	if (argc > 5 && spn_isstrguserinfo(&argv[5])) {
+		spn_SDL_Gradient *gradient = spnlib_sdl2_gradient_from_value(&argv[5]);
+
+		if (gradient == NULL) {
+			spn_ctx_runtime_error(ctx, "6th argument is not a valid gradient", NULL);
+			return -2;
+		}
+
+		texture = spnlib_sdl2_gradient_texture(
+			window->renderer,
+			window->format,
+			gradient,
+			SPN_SDL_GRADIENT_LINEAR,
+			w,
+			h,
+			dx,
+			dy
+		);
+	} else {
+		CHECK_ARG_RETURN_ON_ERROR(5, array);
+
+		SpnArray *arr = ARRAYARG(5);
+		size_t n_stops = spn_array_count(arr);
+		SPN_SDL_ColorStop color_stops[n_stops];
+		bool success = spnlib_sdl2_array_to_colorstop(arr, color_stops);
+
+		if (!success) {
+			spn_ctx_runtime_error(ctx, "invalid color stop specification", NULL);
+			return -2;
+		}
+
+		texture = spnlib_sdl2_cached_linear_gradient(
+			window->renderer,
+			window->format,
+			w,
+			h,
+			dx,
+			dy,
+			color_stops,
+			n_stops
+		);
+	}
+
+	if (texture == NULL) {
+		spn_ctx_runtime_error(ctx, "invalid dimensions or bad number of color stops", NULL);
+		return -3;
+	}
+
+	*ret = spn_makestrguserinfo(texture);
+	return 0;
+}
+
+static int spnlib_SDL_Window_ellipsoidalGradient(
+	SpnValue *ret,
+	int argc,
+	SpnValue *argv,
+	void *ctx,
+	SPN_SDL_GradientKind kind
+)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap); // window
+	CHECK_ARG_RETURN_ON_ERROR(1, number);  // rx
+	CHECK_ARG_RETURN_ON_ERROR(2, number);  // ry
+	                                       // 3: color-stops or Gradient object
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	int rx = NUMARG(1);
+	int ry = NUMARG(2);
+
+	spn_SDL_Texture *texture;
+
+	if (argc > 3 && spn_isstrguserinfo(&argv[3])) {
+		spn_SDL_Gradient *gradient = spnlib_sdl2_gradient_from_value(&argv[3]);
+
+		if (gradient == NULL) {
+			spn_ctx_runtime_error(ctx, "4th argument is not a valid gradient", NULL);
+			return -2;
+		}
+
+		texture = rx < 0 || ry < 0 ? NULL : spnlib_sdl2_gradient_texture(
+			window->renderer,
+			window->format,
+			gradient,
+			kind,
+			2 * rx,
+			2 * ry,
+			0,
+			0
+		);
+	} else {
+		CHECK_ARG_RETURN_ON_ERROR(3, array);
+
+		SpnArray *arr = ARRAYARG(3);
+		size_t n_stops = spn_array_count(arr);
+		SPN_SDL_ColorStop color_stops[n_stops];
+		bool success = spnlib_sdl2_array_to_colorstop(arr, color_stops);
+
+		if (!success) {
+			spn_ctx_runtime_error(ctx, "invalid color stop specification", NULL);
+			return -2;
+		}
+
+		spn_SDL_Texture *(*gradientPainter)(
+			SDL_Renderer *renderer,
+			Uint32 format,
+			int rx,
+			int ry,
+			const SPN_SDL_ColorStop color_stops[],
+			unsigned n
+		) = kind == SPN_SDL_GRADIENT_RADIAL
+		  ? spnlib_sdl2_cached_radial_gradient
+		  : spnlib_sdl2_cached_conical_gradient;
+
+		texture = gradientPainter(
+			window->renderer,
+			window->format,
+			rx,
+			ry,
+			color_stops,
+			n_stops
+		);
+	}
+
+	if (texture == NULL) {
+		spn_ctx_runtime_error(ctx, "invalid dimensions or bad number of color stops", NULL);
+		return -3;
+	}
+
+	*ret = spn_makestrguserinfo(texture);
 	return 0;
 }
 
@@ -1025,7 +2050,7 @@ static int spnlib_SDL_Window_radialGradient(SpnValue *ret, int argc, SpnValue *a
 		argc,
 		argv,
 		ctx,
-		spnlib_sdl2_radial_gradient
+		SPN_SDL_GRADIENT_RADIAL
 	);
 }
 
@@ -1036,10 +2061,320 @@ static int spnlib_SDL_Window_conicalGradient(SpnValue *ret, int argc, SpnValue *
 		argc,
 		argv,
 		ctx,
-		spnlib_sdl2_conical_gradient
+		SPN_SDL_GRADIENT_CONICAL
+	);
+}
+
+// Enables caching of gradient textures generated by this window.
+// Parameters:
+// 0. the window object
+// 1. maximal total size of cached textures in bytes (0 disables caching)
+static int spnlib_SDL_Window_setGradientCacheSize(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, number);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	double bytes = NUMARG(1);
+	spnlib_sdl2_gradient_cache_set_capacity(window->renderer, bytes > 0 ? bytes : 0);
+
+	return 0;
+}
+
+// Drops every cached gradient texture of the window
+static int spnlib_SDL_Window_purgeGradientCache(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	spnlib_sdl2_gradient_cache_purge(window->renderer);
+
+	return 0;
+}
+
+// Creates a blank texture that gradients can be rendered into
+// repeatedly, without allocating a new texture every time.
+// Parameters:
+// 0. the window object
+// 1. width of the texture
+// 2. height of the texture
+static int spnlib_SDL_Window_createStreamingTexture(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, number); // w
+	CHECK_ARG_RETURN_ON_ERROR(2, number); // h
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	int w = NUMARG(1);
+	int h = NUMARG(2);
+
+	if (w <= 0 || h <= 0) {
+		spn_ctx_runtime_error(ctx, "invalid dimensions", NULL);
+		return -2;
+	}
+
+	spn_SDL_Texture *texture = spnlib_SDL_texture_new_streaming(window->renderer, w, h, window->format);
+
+	// implicitly return nil if the texture could not be created
+	if (texture) {
+		*ret = spn_makestrguserinfo(texture);
+	}
+
+	return 0;
+}
+
+// Parameters:
+// 0. the window object
+// 1. the streaming texture to render into
+// 2. delta x (for computing slope)
+// 3. delta y        - " -
+// 4. color-stops or Gradient object
+static int spnlib_SDL_Window_linearGradientInto(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+	CHECK_ARG_RETURN_ON_ERROR(1, strguserinfo);
+	CHECK_ARG_RETURN_ON_ERROR(2, number);
+	CHECK_ARG_RETURN_ON_ERROR(3, number);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	spn_SDL_Texture *texture = OBJARG(1);
+	if (!spn_object_member_of_class(texture, &spn_SDL_Texture_class)) {
+		spn_ctx_runtime_error(ctx, "2nd argument is not a valid texture", NULL);
+		return -2;
+	}
+
+	double dx = NUMARG(2);
+	double dy = NUMARG(3);
+	bool success;
+
+	if (argc > 4 && spn_isstrguserinfo(&argv[4])) {
+		spn_SDL_Gradient *gradient = spnlib_sdl2_gradient_from_value(&argv[4]);
+
+		if (gradient == NULL) {
+			spn_ctx_runtime_error(ctx, "5th argument is not a valid gradient", NULL);
+			return -3;
+		}
+
+		success = spnlib_sdl2_gradient_render_into(
+			texture->texture,
+			gradient,
+			SPN_SDL_GRADIENT_LINEAR,
+			dx,
+			dy
+		);
+	} else {
+		CHECK_ARG_RETURN_ON_ERROR(4, array);
+
+		SpnArray *arr = ARRAYARG(4);
+		size_t n_stops = spn_array_count(arr);
+		SPN_SDL_ColorStop color_stops[n_stops];
+
+		if (!spnlib_sdl2_array_to_colorstop(arr, color_stops)) {
+			spn_ctx_runtime_error(ctx, "invalid color stop specification", NULL);
+			return -3;
+		}
+
+		success = spnlib_sdl2_linear_gradient_into(texture->texture, dx, dy, color_stops, n_stops);
+	}
+
+	if (!success) {
+		spn_ctx_runtime_error(ctx, "texture is not streaming or bad gradient parameters", NULL);
+		return -4;
+	}
+
+	return 0;
+}
+
+static int spnlib_SDL_Window_ellipsoidalGradientInto(
+	SpnValue *ret,
+	int argc,
+	SpnValue *argv,
+	void *ctx,
+	SPN_SDL_GradientKind kind
+)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);      // window
+	CHECK_ARG_RETURN_ON_ERROR(1, strguserinfo); // texture
+	                                            // 2: color-stops or Gradient object
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	spn_SDL_Texture *texture = OBJARG(1);
+	if (!spn_object_member_of_class(texture, &spn_SDL_Texture_class)) {
+		spn_ctx_runtime_error(ctx, "2nd argument is not a valid texture", NULL);
+		return -2;
+	}
+
+	bool success;
+
+	if (argc > 2 && spn_isstrguserinfo(&argv[2])) {
+		spn_SDL_Gradient *gradient = spnlib_sdl2_gradient_from_value(&argv[2]);
+
+		if (gradient == NULL) {
+			spn_ctx_runtime_error(ctx, "3rd argument is not a valid gradient", NULL);
+			return -3;
+		}
+
+		success = spnlib_sdl2_gradient_render_into(texture->texture, gradient, kind, 0, 0);
+	} else {
+		CHECK_ARG_RETURN_ON_ERROR(2, array);
+
+		SpnArray *arr = ARRAYARG(2);
+		size_t n_stops = spn_array_count(arr);
+		SPN_SDL_ColorStop color_stops[n_stops];
+
+		if (!spnlib_sdl2_array_to_colorstop(arr, color_stops)) {
+			spn_ctx_runtime_error(ctx, "invalid color stop specification", NULL);
+			return -3;
+		}
+
+		success = kind == SPN_SDL_GRADIENT_RADIAL
+		        ? spnlib_sdl2_radial_gradient_into(texture->texture, color_stops, n_stops)
+		        : spnlib_sdl2_conical_gradient_into(texture->texture, color_stops, n_stops);
+	}
+
+	if (!success) {
+		spn_ctx_runtime_error(ctx, "texture is not streaming or bad number of color stops", NULL);
+		return -4;
+	}
+
+	return 0;
+}
+
+static int spnlib_SDL_Window_radialGradientInto(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	return spnlib_SDL_Window_ellipsoidalGradientInto(
+		ret,
+		argc,
+		argv,
+		ctx,
+		SPN_SDL_GRADIENT_RADIAL
+	);
+}
+
+static int spnlib_SDL_Window_conicalGradientInto(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	return spnlib_SDL_Window_ellipsoidalGradientInto(
+		ret,
+		argc,
+		argv,
+		ctx,
+		SPN_SDL_GRADIENT_CONICAL
 	);
 }
 
+static bool get_gradient_kind(const char *name, SPN_SDL_GradientKind *kind)
+{
+	if (strcmp(name, "linear") == 0) {
+		*kind = SPN_SDL_GRADIENT_LINEAR;
+	} else if (strcmp(name, "radial") == 0) {
+		*kind = SPN_SDL_GRADIENT_RADIAL;
+	} else if (strcmp(name, "conical") == 0) {
+		*kind = SPN_SDL_GRADIENT_CONICAL;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+// Makes fillRect(), fillEllipse(), fillPolygon() and fillRoundedRect()
+// paint with a gradient instead of the drawing color.
+// Parameters:
+// 0. the window object
+// 1. Gradient object, or nil to go back to filling with the drawing color
+// 2. "linear", "radial" or "conical"
+// 3, 4. linear: start point (x0, y0); radial, conical: center (cx, cy)
+// 5, 6. linear: end point (x1, y1); radial: semi-axes (rx, ry);
+//       conical: not needed
+static int spnlib_SDL_Window_setFillGradient(SpnValue *ret, int argc, SpnValue *argv, void *ctx)
+{
+	CHECK_ARG_RETURN_ON_ERROR(0, hashmap);
+
+	SpnHashMap *hm = HASHMAPARG(0);
+	spn_SDL_Window *window = window_from_hashmap(hm);
+
+	if (window == NULL) {
+		spn_ctx_runtime_error(ctx, "window object is invalid", NULL);
+		return -1;
+	}
+
+	SPN_SDL_GradientPaint paint = { NULL, SPN_SDL_GRADIENT_LINEAR, 0, 0, 0, 0 };
+
+	if (argc > 1 && !spn_isnil(&argv[1])) {
+		paint.gradient = spnlib_sdl2_gradient_from_value(&argv[1]);
+
+		if (paint.gradient == NULL) {
+			spn_ctx_runtime_error(ctx, "2nd argument is not a valid gradient", NULL);
+			return -2;
+		}
+
+		CHECK_ARG_RETURN_ON_ERROR(2, string);
+		CHECK_ARG_RETURN_ON_ERROR(3, number);
+		CHECK_ARG_RETURN_ON_ERROR(4, number);
+
+		if (!get_gradient_kind(STRARG(2), &paint.kind)) {
+			spn_ctx_runtime_error(ctx, "gradient kind must be 'linear', 'radial' or 'conical'", NULL);
+			return -3;
+		}
+
+		paint.x0 = NUMARG(3);
+		paint.y0 = NUMARG(4);
+
+		if (paint.kind != SPN_SDL_GRADIENT_CONICAL) {
+			CHECK_ARG_RETURN_ON_ERROR(5, number);
+			CHECK_ARG_RETURN_ON_ERROR(6, number);
+
+			paint.x1 = NUMARG(5);
+			paint.y1 = NUMARG(6);
+		}
+
+		spn_object_retain(paint.gradient);
+	}
+
+	if (window->paint.gradient) {
+		spn_object_release(window->paint.gradient);
+	}
+
+	window->paint = paint;
+
+	return 0;
+}
+
 /////////////////////////////////
 ///////    Message Box    ///////
 /////////////////////////////////
@@ -1168,33 +2503,62 @@ static int spnlib_SDL_Window_ShowMessageBox(SpnValue *ret, int argc, SpnValue *a
 void spnlib_SDL_methods_for_Window(SpnHashMap *window)
 {
 	static const SpnExtFunc methods[] = {
-		{ "refresh",           spnlib_SDL_Window_refresh           },
-		{ "setBlendMode",      spnlib_SDL_Window_setBlendMode      },
-		{ "getBlendMode",      spnlib_SDL_Window_getBlendMode      },
-		{ "setColor",          spnlib_SDL_Window_setColor          },
-		{ "getColor",          spnlib_SDL_Window_getColor          },
-		{ "setFont",           spnlib_SDL_Window_setFont           },
-		{ "clear",             spnlib_SDL_Window_clear             },
-		{ "strokeRect",        spnlib_SDL_Window_strokeRect        },
-		{ "fillRect",          spnlib_SDL_Window_fillRect          },
-		{ "strokeArc",         spnlib_SDL_Window_strokeArc         },
-		{ "fillArc",           spnlib_SDL_Window_fillArc           },
-		{ "strokeEllipse",     spnlib_SDL_Window_strokeEllipse     },
-		{ "fillEllipse",       spnlib_SDL_Window_fillEllipse       },
-		{ "fillPolygon",       spnlib_SDL_Window_fillPolygon       },
-		{ "strokeRoundedRect", spnlib_SDL_Window_strokeRoundedRect },
-		{ "fillRoundedRect",   spnlib_SDL_Window_fillRoundedRect   },
-		{ "bezier",            spnlib_SDL_Window_bezier            },
-		{ "line",              spnlib_SDL_Window_line              },
-		{ "point",             spnlib_SDL_Window_point             },
-		{ "renderText",        spnlib_SDL_Window_renderText        },
-		{ "textSize",          spnlib_SDL_Window_textSize          },
-		{ "renderTexture",     spnlib_SDL_Window_renderTexture     },
-		{ "loadImage",         spnlib_SDL_Window_loadImage         },
-		{ "linearGradient",    spnlib_SDL_Window_linearGradient    },
-		{ "radialGradient",    spnlib_SDL_Window_radialGradient    },
-		{ "conicalGradient",   spnlib_SDL_Window_conicalGradient   },
-		{ "showMessageBox",    spnlib_SDL_Window_ShowMessageBox    }
+		{ "refresh",                spnlib_SDL_Window_refresh                },
+		{ "setBlendMode",           spnlib_SDL_Window_setBlendMode           },
+		{ "getBlendMode",           spnlib_SDL_Window_getBlendMode           },
+		{ "setColor",               spnlib_SDL_Window_setColor               },
+		{ "getColor",               spnlib_SDL_Window_getColor               },
+		{ "preloadFonts",           spnlib_SDL_Window_preloadFonts           },
+		{ "setFont",                spnlib_SDL_Window_setFont                },
+		{ "clear",                  spnlib_SDL_Window_clear                  },
+		{ "strokeRect",             spnlib_SDL_Window_strokeRect             },
+		{ "fillRect",               spnlib_SDL_Window_fillRect               },
+		{ "strokeArc",              spnlib_SDL_Window_strokeArc              },
+		{ "fillArc",                spnlib_SDL_Window_fillArc                },
+		{ "strokeEllipse",          spnlib_SDL_Window_strokeEllipse          },
+		{ "fillEllipse",            spnlib_SDL_Window_fillEllipse            },
+		{ "fillPolygon",            spnlib_SDL_Window_fillPolygon            },
+		{ "strokeRoundedRect",      spnlib_SDL_Window_strokeRoundedRect      },
+		{ "fillRoundedRect",        spnlib_SDL_Window_fillRoundedRect        },
+		{ "bezier",                 spnlib_SDL_Window_bezier                 },
+		{ "line",                   spnlib_SDL_Window_line                   },
+		{ "point",                  spnlib_SDL_Window_point                  },
+		{ "renderText",             spnlib_SDL_Window_renderText             },
+		{ "drawText",               spnlib_SDL_Window_drawText               },
+		{ "createLabel",            spnlib_SDL_Window_createLabel            },
+		{ "createConsole",          spnlib_SDL_Window_createConsole          },
+		{ "textSize",               spnlib_SDL_Window_textSize               },
+		{ "measureTexts",           spnlib_SDL_Window_measureTexts           },
+		{ "textBoxSize",            spnlib_SDL_Window_textBoxSize            },
+		{ "drawTextBox",            spnlib_SDL_Window_drawTextBox            },
+		{ "renderTexture",          spnlib_SDL_Window_renderTexture          },
+		{ "setTextureColorMod",     spnlib_SDL_Window_setTextureColorMod     },
+		{ "setTextureAlphaMod",     spnlib_SDL_Window_setTextureAlphaMod     },
+		{ "setTextureBlendMode",    spnlib_SDL_Window_setTextureBlendMode    },
+		{ "loadImage",              spnlib_SDL_Window_loadImage              },
+		{ "loadImageFromBuffer",    spnlib_SDL_Window_loadImageFromBuffer    },
+		{ "loadImageMapped",        spnlib_SDL_Window_loadImageMapped        },
+		{ "loadTiledImage",         spnlib_SDL_Window_loadTiledImage         },
+		{ "loadPackedImage",        spnlib_SDL_Window_loadPackedImage        },
+		{ "pixelFormat",            spnlib_SDL_Window_pixelFormat            },
+		{ "loadImageAsync",         spnlib_SDL_Window_loadImageAsync         },
+		{ "setImageCacheSize",      spnlib_SDL_Window_setImageCacheSize      },
+		{ "purgeImageCache",        spnlib_SDL_Window_purgeImageCache        },
+		{ "imageCacheStats",        spnlib_SDL_Window_imageCacheStats        },
+		{ "loadBitmapFont",         spnlib_SDL_Window_loadBitmapFont         },
+		{ "linearGradient",         spnlib_SDL_Window_linearGradient         },
+		{ "radialGradient",         spnlib_SDL_Window_radialGradient         },
+		{ "conicalGradient",        spnlib_SDL_Window_conicalGradient        },
+		{ "createStreamingTexture", spnlib_SDL_Window_createStreamingTexture },
+		{ "linearGradientInto",     spnlib_SDL_Window_linearGradientInto     },
+		{ "radialGradientInto",     spnlib_SDL_Window_radialGradientInto     },
+		{ "conicalGradientInto",    spnlib_SDL_Window_conicalGradientInto    },
+		{ "setGradientCacheSize",   spnlib_SDL_Window_setGradientCacheSize   },
+		{ "setTextCacheSize",       spnlib_SDL_Window_setTextCacheSize       },
+		{ "textCacheStats",         spnlib_SDL_Window_textCacheStats         },
+		{ "purgeGradientCache",     spnlib_SDL_Window_purgeGradientCache     },
+		{ "setFillGradient",        spnlib_SDL_Window_setFillGradient        },
+		{ "showMessageBox",         spnlib_SDL_Window_ShowMessageBox         }
 	};
 
 	for (size_t i = 0; i < COUNT(methods); i++) {
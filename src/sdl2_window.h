@@ -16,7 +16,24 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
+#include <SDL2/SDL_ttf.h>
 
+#include "sdl2_gradient.h"
+#include "sdl2_bmfont.h"
+
+typedef struct spn_SDL_Window {
+	SpnObject base;
+	SDL_Window *window;
+	SDL_Renderer *renderer;
+	TTF_Font *font;
+	spn_SDL_BitmapFont *bitmap_font; // retained; used instead of 'font' if set
+	SPN_SDL_GradientPaint paint; // used by the fill*() methods
+	Uint32 format; // preferred texture format of the renderer
+} spn_SDL_Window;
+
+// Retrieves an internal window descriptor from
+// a "public" window object. Returns NULL if invalid.
+spn_SDL_Window *window_from_hashmap(SpnHashMap *hm);
 
 int spnlib_SDL_OpenWindow(SpnValue *ret, int argc, SpnValue *argv, void *ctx);
 
@@ -0,0 +1,149 @@
+//
+// assetpack.cpp
+// sdl2-sparkling
+//
+// Decodes every image in a directory (recursively) and writes them into
+// an asset pack, which SDL::OpenAssetPack() can load without decoding.
+//
+// Usage: assetpack [--format=name] output.pack directory
+//
+// Images are named by their path relative to 'directory', e. g.
+// "sprites/hero.png". 'format' is the texture format the pixels are
+// stored in, e. g. ARGB8888 (the default); it should be the one that
+// Window::pixelFormat() returns on the target platform, otherwise the
+// driver has to convert the pixels when they are uploaded.
+//
+// Licensed under the 2-clause BSD License
+//
+
+#define SDL_MAIN_HANDLED
+
+#include "sdl2_assetpack.h"
+#include "sdl2_image.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+static bool parse_format(const char *name, Uint32 *format)
+{
+	static const Uint32 formats[] = {
+		SDL_PIXELFORMAT_ARGB8888,
+		SDL_PIXELFORMAT_RGBA8888,
+		SDL_PIXELFORMAT_ABGR8888,
+		SDL_PIXELFORMAT_BGRA8888
+	};
+
+	static const char prefix[] = "SDL_PIXELFORMAT_";
+
+	if (std::strncmp(name, prefix, sizeof prefix - 1) == 0) {
+		name += sizeof prefix - 1;
+	}
+
+	for (Uint32 f : formats) {
+		if (std::strcmp(SDL_GetPixelFormatName(f) + sizeof prefix - 1, name) == 0) {
+			*format = f;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Collects the paths of regular files below 'directory', relative to it
+static void list_files(const std::string &directory, const std::string &prefix, std::vector<std::string> *files)
+{
+	DIR *dir = opendir(directory.c_str());
+	if (dir == nullptr) {
+		return;
+	}
+
+	while (struct dirent *entry = readdir(dir)) {
+		if (entry->d_name[0] == '.') {
+			continue;
+		}
+
+		std::string path = directory + "/" + entry->d_name;
+		std::string name = prefix + entry->d_name;
+
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0) {
+			continue;
+		}
+
+		if (S_ISDIR(st.st_mode)) {
+			list_files(path, name + "/", files);
+		} else if (S_ISREG(st.st_mode)) {
+			files->push_back(name);
+		}
+	}
+
+	closedir(dir);
+}
+
+int main(int argc, char *argv[])
+{
+	Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+	int argi = 1;
+
+	if (argi < argc && std::strncmp(argv[argi], "--format=", 9) == 0) {
+		if (!parse_format(argv[argi] + 9, &format)) {
+			std::fprintf(stderr, "unsupported format: %s\n", argv[argi] + 9);
+			return 1;
+		}
+
+		argi++;
+	}
+
+	if (argc - argi != 2) {
+		std::fprintf(stderr, "usage: %s [--format=name] output.pack directory\n", argv[0]);
+		return 1;
+	}
+
+	const char *output = argv[argi];
+	std::string directory = argv[argi + 1];
+
+	std::vector<std::string> files;
+	list_files(directory, "", &files);
+	std::sort(files.begin(), files.end());
+
+	std::vector<const char *> names;
+	std::vector<SDL_Surface *> surfaces;
+
+	for (const std::string &file : files) {
+		SDL_Surface *surface = spnlib_sdl2_decode_image((directory + "/" + file).c_str(), format);
+
+		if (surface == nullptr) {
+			std::fprintf(stderr, "skipping %s: %s\n", file.c_str(), SDL_GetError());
+			continue;
+		}
+
+		names.push_back(file.c_str());
+		surfaces.push_back(surface);
+	}
+
+	bool success = spnlib_sdl2_assetpack_write(
+		output,
+		format,
+		names.data(),
+		surfaces.data(),
+		surfaces.size()
+	);
+
+	for (SDL_Surface *surface : surfaces) {
+		SDL_FreeSurface(surface);
+	}
+
+	if (!success) {
+		std::fprintf(stderr, "can't write %s\n", output);
+		return 1;
+	}
+
+	std::printf("packed %zu images into %s\n", surfaces.size(), output);
+	return 0;
+}